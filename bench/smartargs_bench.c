@@ -0,0 +1,359 @@
+/*
+ * SmartArgs Benchmark
+ * Measures parser cost on synthetic option tables and argument vectors:
+ * ns/token, heap allocations and peak RSS for cli_parse, cli_parse_spec
+ * with a precompiled table, and getopt_long as a baseline.
+ *
+ * Every measurement runs in a forked child so peak RSS is per case.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "smartargs.h"
+
+/* Allocation counters, fed by the --wrap'd allocator when available (-1 otherwise) */
+#ifdef SMARTARGS_BENCH_WRAP_MALLOC
+static long long alloc_count = 0;
+static long long alloc_bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+#else
+static long long alloc_count = -1;
+static long long alloc_bytes = -1;
+#endif
+
+typedef enum {
+    PARSER_CLI_PARSE,
+    PARSER_CLI_PARSE_SPEC,
+    PARSER_GETOPT_LONG
+} BenchParser;
+
+static const char *parser_names[] = {"cli_parse", "cli_parse_spec", "getopt_long"};
+
+typedef struct {
+    int ok;
+    int iterations;
+    double best_ns_per_token;
+    double mean_ns_per_token;
+    long long allocs_per_parse;
+    long long bytes_per_parse;
+    long peak_rss_kb;
+} Measurement;
+
+/* Synthetic workload: option i is a flag, int or string by i % 3 */
+typedef struct {
+    int option_count;
+    char **names;
+    Option *options;
+    int *ints;
+    const char **strings;
+    int token_count;
+    char **argv;
+} Workload;
+
+static const char short_names[] = "abcdefgijklmnopqrstuvwxyzABCDEFGIJKLMNOPQRSTUVWXYZ";
+
+static char *dup_printf(const char *format, int value) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), format, value);
+    return strdup(buffer);
+}
+
+static void build_workload(Workload *w, int option_count, int token_count) {
+    w->option_count = option_count;
+    w->names = calloc(option_count, sizeof(char*));
+    w->options = calloc(option_count, sizeof(Option));
+    w->ints = calloc(option_count, sizeof(int));
+    w->strings = calloc(option_count, sizeof(char*));
+
+    for (int i = 0; i < option_count; i++) {
+        w->names[i] = dup_printf("option-%d", i);
+        Option *opt = &w->options[i];
+        opt->long_name = w->names[i];
+        opt->short_name = i < (int)sizeof(short_names) - 1 ? short_names[i] : 0;
+        opt->help = "Synthetic option";
+        switch (i % 3) {
+            case 0: opt->type = OPT_FLAG; opt->value = &w->ints[i]; break;
+            case 1: opt->type = OPT_INT; opt->value = &w->ints[i]; break;
+            default: opt->type = OPT_STRING; opt->value = &w->strings[i]; break;
+        }
+    }
+
+    /* Token kinds rotate: --name value, --name=value, -x [value], positional */
+    w->argv = calloc(token_count + 2, sizeof(char*));
+    w->argv[0] = "bench";
+    int n = 1;
+    unsigned seed = 12345;
+    for (int k = 0; n <= token_count; k++) {
+        seed = seed * 1103515245u + 12345u;
+        int i = (int)((seed >> 8) % (unsigned)option_count);
+        Option *opt = &w->options[i];
+        const char *value = opt->type == OPT_INT ? "42" : "value";
+
+        /* A separate value needs a second slot; fall back to a positional */
+        int kind = k % 4;
+        int room = token_count - n + 1;
+        if ((kind == 0 || kind == 2) && opt->type != OPT_FLAG && room < 2) {
+            kind = 3;
+        }
+        if (kind == 2 && !opt->short_name) {
+            kind = 3;
+        }
+
+        char buffer[64];
+        switch (kind) {
+            case 0:
+                w->argv[n++] = dup_printf("--option-%d", i);
+                if (opt->type != OPT_FLAG) {
+                    w->argv[n++] = (char*)value;
+                }
+                break;
+            case 1:
+                if (opt->type == OPT_FLAG) {
+                    snprintf(buffer, sizeof(buffer), "--option-%d", i);
+                } else {
+                    snprintf(buffer, sizeof(buffer), "--option-%d=%s", i, value);
+                }
+                w->argv[n++] = strdup(buffer);
+                break;
+            case 2:
+                snprintf(buffer, sizeof(buffer), "-%c", opt->short_name);
+                w->argv[n++] = strdup(buffer);
+                if (opt->type != OPT_FLAG) {
+                    w->argv[n++] = (char*)value;
+                }
+                break;
+            default:
+                w->argv[n++] = dup_printf("file-%d.txt", k);
+                break;
+        }
+    }
+    w->token_count = token_count;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static struct option *build_getopt_table(const Workload *w, char **optstring) {
+    struct option *table = calloc(w->option_count + 1, sizeof(struct option));
+    char *shorts = calloc(w->option_count * 2 + 3, 1);
+    char *s = shorts;
+
+    /* "-" returns positionals in order instead of permuting, like cli_parse */
+    *s++ = '-';
+
+    for (int i = 0; i < w->option_count; i++) {
+        const Option *opt = &w->options[i];
+        table[i].name = opt->long_name;
+        table[i].has_arg = opt->type == OPT_FLAG ? no_argument : required_argument;
+        if (opt->short_name) {
+            *s++ = opt->short_name;
+            if (opt->type != OPT_FLAG) {
+                *s++ = ':';
+            }
+        }
+    }
+    *optstring = shorts;
+    return table;
+}
+
+/* Run one parser over the workload until min_time_ms has elapsed */
+static Measurement measure(BenchParser parser, int option_count, int token_count, double min_time_ms) {
+    Measurement m = {0};
+    Workload w;
+    build_workload(&w, option_count, token_count);
+
+    int argc = token_count + 1;
+    char **scratch = calloc(argc + 1, sizeof(char*));
+    OptionSpec *spec = parser == PARSER_CLI_PARSE_SPEC ? cli_compile(w.options, option_count) : NULL;
+    char *optstring = NULL;
+    struct option *table = parser == PARSER_GETOPT_LONG ? build_getopt_table(&w, &optstring) : NULL;
+
+    double total = 0;
+    double best = 0;
+    long long allocs = 0;
+    long long bytes = 0;
+    m.ok = 1;
+
+    while (total < min_time_ms * 1e6 || m.iterations < 3) {
+        /* Every run starts from a fresh copy in case the parser reorders argv */
+        memcpy(scratch, w.argv, sizeof(char*) * (argc + 1));
+        ParseResult result;
+        long long count_before = alloc_count;
+        long long bytes_before = alloc_bytes;
+        double start = now_ns();
+
+        switch (parser) {
+            case PARSER_CLI_PARSE:
+                m.ok &= cli_parse(argc, scratch, w.options, option_count, &result) == 0;
+                cli_free(&result);
+                break;
+            case PARSER_CLI_PARSE_SPEC:
+                m.ok &= cli_parse_spec(spec, argc, scratch, &result) == 0;
+                cli_free(&result);
+                break;
+            case PARSER_GETOPT_LONG:
+                optind = 0;
+                opterr = 0;
+                while (getopt_long(argc, scratch, optstring, table, NULL) != -1) {
+                }
+                break;
+        }
+
+        double elapsed = now_ns() - start;
+        allocs = alloc_count - count_before;
+        bytes = alloc_bytes - bytes_before;
+        total += elapsed;
+        if (m.iterations == 0 || elapsed < best) {
+            best = elapsed;
+        }
+        m.iterations++;
+    }
+
+    m.best_ns_per_token = best / token_count;
+    m.mean_ns_per_token = total / m.iterations / token_count;
+    m.allocs_per_parse = alloc_count < 0 ? -1 : allocs;
+    m.bytes_per_parse = alloc_bytes < 0 ? -1 : bytes;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    m.peak_rss_kb = usage.ru_maxrss;
+
+    cli_spec_free(spec);
+    return m;
+}
+
+static Measurement measure_in_child(BenchParser parser, int option_count, int token_count, double min_time_ms) {
+    Measurement m = {0};
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return m;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        Measurement child = measure(parser, option_count, token_count, min_time_ms);
+        ssize_t written = write(fds[1], &child, sizeof(child));
+        _exit(written == (ssize_t)sizeof(child) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid > 0) {
+        if (read(fds[0], &m, sizeof(m)) != (ssize_t)sizeof(m)) {
+            m.ok = 0;
+        }
+        waitpid(pid, NULL, 0);
+    }
+    close(fds[0]);
+    return m;
+}
+
+int main(int argc, char *argv[]) {
+    int help = 0;
+    int json = 0;
+    int csv = 0;
+    int quick = 0;
+    int max_options = 5000;
+    int max_tokens = 1000000;
+    double min_time_ms = 200.0;
+    double baseline_limit = 2e8;
+
+    CONFIGURE(argc, argv, "SmartArgs parser benchmark", help,
+        FLAG(json, 'j', "json", "Emit one JSON object per measurement"),
+        FLAG(csv, 'c', "csv", "Emit CSV with a header line"),
+        FLAG(quick, 'q', "quick", "Small sizes and short runs, for smoke testing"),
+        INT(max_options, 'o', "max-options", "Largest option table (10 to 5000)"),
+        INT(max_tokens, 'n', "max-tokens", "Longest argument vector (10 to 1000000)"),
+        DOUBLE(min_time_ms, 't', "min-time", "Minimum time per measurement in ms"),
+        DOUBLE(baseline_limit, 'b', "baseline-limit", "Skip getopt_long when options x tokens exceeds this")
+    );
+
+    static const int option_sizes[] = {10, 100, 1000, 5000};
+    static const int token_sizes[] = {10, 1000, 100000, 1000000};
+    if (quick) {
+        max_options = max_options < 100 ? max_options : 100;
+        max_tokens = max_tokens < 1000 ? max_tokens : 1000;
+        min_time_ms = 5.0;
+    }
+
+    if (csv) {
+        printf("parser,options,tokens,iterations,best_ns_per_token,mean_ns_per_token,"
+               "allocs_per_parse,bytes_per_parse,peak_rss_kb\n");
+    } else if (!json) {
+        printf("%-15s %8s %8s %12s %12s %10s %12s %10s\n", "parser", "options", "tokens",
+               "best ns/tok", "mean ns/tok", "allocs", "bytes", "rss KB");
+    }
+
+    int failed = 0;
+    for (size_t o = 0; o < sizeof(option_sizes) / sizeof(option_sizes[0]); o++) {
+        for (size_t t = 0; t < sizeof(token_sizes) / sizeof(token_sizes[0]); t++) {
+            int options = option_sizes[o];
+            int tokens = token_sizes[t];
+            if (options > max_options || tokens > max_tokens) {
+                continue;
+            }
+
+            for (int p = PARSER_CLI_PARSE; p <= PARSER_GETOPT_LONG; p++) {
+                if (p == PARSER_GETOPT_LONG && (double)options * tokens > baseline_limit) {
+                    continue;
+                }
+                Measurement m = measure_in_child((BenchParser)p, options, tokens, min_time_ms);
+                if (!m.ok) {
+                    fprintf(stderr, "%s failed on %d options, %d tokens\n", parser_names[p], options, tokens);
+                    failed = 1;
+                    continue;
+                }
+
+                if (json) {
+                    printf("{\"parser\":\"%s\",\"options\":%d,\"tokens\":%d,\"iterations\":%d,"
+                           "\"best_ns_per_token\":%.2f,\"mean_ns_per_token\":%.2f,"
+                           "\"allocs_per_parse\":%lld,\"bytes_per_parse\":%lld,\"peak_rss_kb\":%ld}\n",
+                           parser_names[p], options, tokens, m.iterations, m.best_ns_per_token,
+                           m.mean_ns_per_token, m.allocs_per_parse, m.bytes_per_parse, m.peak_rss_kb);
+                } else if (csv) {
+                    printf("%s,%d,%d,%d,%.2f,%.2f,%lld,%lld,%ld\n", parser_names[p], options, tokens,
+                           m.iterations, m.best_ns_per_token, m.mean_ns_per_token,
+                           m.allocs_per_parse, m.bytes_per_parse, m.peak_rss_kb);
+                } else {
+                    printf("%-15s %8d %8d %12.2f %12.2f %10lld %12lld %10ld\n", parser_names[p], options,
+                           tokens, m.best_ns_per_token, m.mean_ns_per_token, m.allocs_per_parse,
+                           m.bytes_per_parse, m.peak_rss_kb);
+                }
+                fflush(stdout);
+            }
+        }
+    }
+
+    CLEANUP();
+    return failed;
+}
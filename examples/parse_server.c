@@ -0,0 +1,45 @@
+/*
+ * SmartArgs Parse Server Example
+ * Keeps the option table of a job command resident and validates proposed
+ * command lines sent over a Unix socket, or over stdin without --socket:
+ *
+ *   printf '3\0job\0--threads\0008\0' | parse_server
+ */
+
+#include <stdio.h>
+#include "smartargs.h"
+
+int main(int argc, char *argv[]) {
+    int help = 0;
+    const char *socket_path = NULL;
+    
+    CONFIGURE(argc, argv, "Validate job command lines without starting a process", help,
+        STRING(socket_path, 's', "socket", "Listen on this Unix socket instead of stdin")
+    );
+    
+    // The table being served; these variables only provide defaults
+    int verbose = 0;
+    int threads = 4;
+    size_t memory = 1 << 30;
+    int64_t timeout = 0;
+    const char *input = NULL;
+    const char *output = NULL;
+    Option job_options[] = {
+        FLAG(verbose, 'v', "verbose", "Enable verbose output"),
+        INT(threads, 't', "threads", "Number of worker threads"),
+        SIZE(memory, 'm', "memory", "Memory limit"),
+        DURATION(timeout, 0, "timeout", "Time limit"),
+        STRING_REQUIRED(input, 'i', "input", "Input file"),
+        STRING(output, 'o', "output", "Output file")
+    };
+    OptionSpec *spec = cli_compile(job_options, sizeof(job_options) / sizeof(job_options[0]));
+    
+    int ret = socket_path ? cli_serve_unix(spec, socket_path) : cli_serve_fd(spec, 0, 1);
+    if (ret != 0) {
+        fprintf(stderr, "parse_server: %s\n", socket_path ? "cannot serve socket" : "malformed input");
+    }
+    
+    cli_spec_free(spec);
+    CLEANUP();
+    return ret != 0;
+}
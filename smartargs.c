@@ -1,302 +1,3886 @@
+#define _GNU_SOURCE  /* strtod_l */
 #include "smartargs.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <locale.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define SMARTARGS_HAVE_STRTOD_L
+#endif
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+
+extern char **environ;
+
+/*
+ * Instrumentation, compiled in with SMARTARGS_STATS. The STAT_* macros
+ * expand to nothing otherwise, so the parse path carries no extra work.
+ */
+#ifdef SMARTARGS_STATS
+static __thread CliStats thread_stats;
+static __thread int thread_trace;
+
+static uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void stat_probes(unsigned long probes) {
+    thread_stats.lookups++;
+    thread_stats.probes += probes;
+    if (probes > thread_stats.max_probes) {
+        thread_stats.max_probes = probes;
+    }
+}
+
+#define STAT_ADD(field, n) (thread_stats.field += (n))
+#define STAT_PROBES(n) stat_probes(n)
+#define STAT_CLOCK(var) uint64_t var = stats_now()
+#define STAT_ELAPSED(field, since) (thread_stats.field += stats_now() - (since))
+/* Scan time excludes the conversions made during the scan */
+#define STAT_SCAN_BEGIN() uint64_t scan_started = stats_now(), scan_convert = thread_stats.convert_ns
+#define STAT_SCAN_END() \
+    (thread_stats.scan_ns += stats_now() - scan_started - (thread_stats.convert_ns - scan_convert))
+#else
+#define STAT_ADD(field, n) ((void)0)
+#define STAT_PROBES(n) ((void)0)
+#define STAT_CLOCK(var) ((void)0)
+#define STAT_ELAPSED(field, since) ((void)0)
+#define STAT_SCAN_BEGIN() ((void)0)
+#define STAT_SCAN_END() ((void)0)
+#endif
+
+void cli_stats_get(CliStats *stats) {
+#ifdef SMARTARGS_STATS
+    *stats = thread_stats;
+#else
+    memset(stats, 0, sizeof(CliStats));
+#endif
+}
+
+void cli_stats_reset(void) {
+#ifdef SMARTARGS_STATS
+    memset(&thread_stats, 0, sizeof(CliStats));
+#endif
+}
+
+void cli_stats_dump(FILE *out) {
+    CliStats st;
+    cli_stats_get(&st);
+    fprintf(out, "{\"smartargs\":{\"tokens\":%lu,\"lookups\":%lu,\"probes\":%lu,\"max_probes\":%lu,"
+                 "\"allocations\":%lu,\"bytes\":%lu,\"scan_ns\":%llu,\"convert_ns\":%llu,"
+                 "\"required_ns\":%llu,\"usage_ns\":%llu}}\n",
+            st.tokens, st.lookups, st.probes, st.max_probes, st.allocations, st.bytes,
+            (unsigned long long)st.scan_ns, (unsigned long long)st.convert_ns,
+            (unsigned long long)st.required_ns, (unsigned long long)st.usage_ns);
+}
+
+/* Print the stats when tracing was asked for by --smartargs-trace or SMARTARGS_TRACE */
+static int trace_parse(int ret) {
+#ifdef SMARTARGS_STATS
+    const char *env = getenv("SMARTARGS_TRACE");
+    if (thread_trace || (env && *env && strcmp(env, "0") != 0)) {
+        cli_stats_dump(stderr);
+    }
+#endif
+    return ret;
+}
+
+/* Heap allocations made by the parser, counted in stats builds; a is the caller's allocator or NULL */
+static void *mem_alloc(const CliAllocator *a, size_t size) {
+    STAT_ADD(allocations, 1);
+    STAT_ADD(bytes, size);
+    return a ? a->alloc(a->userdata, size) : malloc(size);
+}
+
+static void *mem_calloc(size_t count, size_t size) {
+    STAT_ADD(allocations, 1);
+    STAT_ADD(bytes, count * size);
+    return calloc(count, size);
+}
+
+static void *mem_realloc(const CliAllocator *a, void *ptr, size_t size) {
+    STAT_ADD(allocations, 1);
+    STAT_ADD(bytes, size);
+    return a ? a->realloc(a->userdata, ptr, size) : realloc(ptr, size);
+}
+
+static void mem_free(const CliAllocator *a, void *ptr) {
+    if (!a) {
+        free(ptr);
+    } else if (ptr) {
+        a->free(a->userdata, ptr);
+    }
+}
 
 /* Global variables for positional arguments */
 char **args = NULL;
 int arg_count = 0;
+ParseResult smartargs_result;
+
+/* Compiled option table: long names are indexed by an open-addressing hash */
+typedef struct {
+    unsigned hash;
+    unsigned len;
+    int index;              /* -1 marks an empty slot */
+} SpecSlot;
+
+/*
+ * Long names are also kept in a trie. Children are sibling lists sorted by
+ * character, and each node knows the one option named below it, if there
+ * is only one: an abbreviation resolves in a single walk, and suggestions
+ * for a misspelt name come from an edit distance bounded during the walk.
+ */
+typedef struct {
+    int child;              /* first child, -1 if none */
+    int sibling;            /* next sibling, with a greater character, -1 if none */
+    int option;             /* option whose long name ends here, -1 if none */
+    int only;               /* the one option named below here: -1 none, -2 several */
+    unsigned char c;
+} TrieNode;
+
+/* Presence bitsets: one bit per option, inline in the parser up to 512 options */
+#define PRESENT_INLINE_WORDS 8
+
+static size_t presence_words(int option_count) {
+    return ((size_t)option_count + 63) / 64;
+}
+
+struct OptionSpec {
+    Option *options;
+    int option_count;
+    unsigned flags;         /* ParseFlags */
+    int help_index;         /* -1 when the table has no help flag */
+    uint64_t *required;     /* bit i set if option i is required, presence_words() words */
+    unsigned mask;          /* slot count - 1, slot count is a power of two */
+    SpecSlot *slots;
+    int short_index[256];   /* option index per short name, -1 if unused */
+    uint64_t name_lengths;  /* bit n set if a long name has length n (63 and longer share bit 63) */
+    unsigned env_mask;      /* the same for the env names of the options, if any */
+    SpecSlot *env_slots;
+    uint64_t env_lengths;
+    TrieNode *trie;         /* long names, node 0 is the root */
+    pthread_mutex_t usage_lock;
+    char *usage;            /* options block rendered by cli_spec_usage(), or NULL ... */
+    size_t usage_length;
+    int usage_width;        /* ... and the terminal width it was rendered for */
+};
+
+/* FNV-1a over a name that is not necessarily NUL-terminated */
+static unsigned hash_name(const char *name, size_t len) {
+    unsigned h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Long names and env names are indexed alike */
+static const char *indexed_name(const Option *opt, int env) {
+    return env ? opt->env : opt->long_name;
+}
+
+/* Add options[i] to a slot table; the first declaration of a duplicate name wins */
+static void index_name(SpecSlot *slots, unsigned mask, const Option *options, int i, int env,
+                       uint64_t *lengths) {
+    const char *name = indexed_name(&options[i], env);
+    size_t len = strlen(name);
+    unsigned h = hash_name(name, len);
+    unsigned pos = h & mask;
+    
+    *lengths |= 1ULL << (len < 63 ? len : 63);
+    while (slots[pos].index >= 0) {
+        const SpecSlot *slot = &slots[pos];
+        if (slot->hash == h && slot->len == len &&
+            memcmp(indexed_name(&options[slot->index], env), name, len) == 0) {
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    slots[pos].hash = h;
+    slots[pos].len = (unsigned)len;
+    slots[pos].index = i;
+}
+
+static Option *lookup_name(const SpecSlot *slots, unsigned mask, Option *options, int env,
+                           const char *name, size_t len) {
+    unsigned h = hash_name(name, len);
+    unsigned pos = h & mask;
+    for (; slots[pos].index >= 0; pos = (pos + 1) & mask) {
+        const SpecSlot *slot = &slots[pos];
+        if (slot->hash == h && slot->len == len &&
+            memcmp(indexed_name(&options[slot->index], env), name, len) == 0) {
+            STAT_PROBES(((pos - h) & mask) + 1);
+            return &options[slot->index];
+        }
+    }
+    STAT_PROBES(((pos - h) & mask) + 1);
+    return NULL;
+}
+
+static int trie_child(const TrieNode *trie, int node, unsigned char c) {
+    for (int n = trie[node].child; n >= 0 && trie[n].c <= c; n = trie[n].sibling) {
+        if (trie[n].c == c) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+/* Node spelling name, or -1 */
+static int trie_walk(const TrieNode *trie, const char *name, size_t len) {
+    int node = 0;
+    for (size_t i = 0; i < len && node >= 0; i++) {
+        node = trie_child(trie, node, (unsigned char)name[i]);
+    }
+    return node;
+}
+
+/* Add the long name of option i; the first declaration of a duplicate name wins */
+static void trie_insert(TrieNode *trie, int *node_count, const char *name, int i) {
+    size_t len = strlen(name);
+    int node = trie_walk(trie, name, len);
+    if (node >= 0 && trie[node].option >= 0) {
+        return;
+    }
+    
+    node = 0;
+    for (size_t k = 0; k < len; k++) {
+        unsigned char c = (unsigned char)name[k];
+        int *link = &trie[node].child;
+        while (*link >= 0 && trie[*link].c < c) {
+            link = &trie[*link].sibling;
+        }
+        if (*link < 0 || trie[*link].c != c) {
+            int n = (*node_count)++;
+            trie[n].child = -1;
+            trie[n].sibling = *link;
+            trie[n].option = -1;
+            trie[n].only = -1;
+            trie[n].c = c;
+            *link = n;
+        }
+        node = *link;
+        trie[node].only = trie[node].only == -1 || trie[node].only == i ? i : -2;
+    }
+    trie[node].option = i;
+}
+
+OptionSpec *cli_compile(Option *options, int option_count) {
+    return cli_compile_ex(options, option_count, 0);
+}
+
+OptionSpec *cli_compile_ex(Option *options, int option_count, unsigned flags) {
+    if (!options || option_count < 0) {
+        return NULL;
+    }
+    
+    /* Keep the load factor at or below one half */
+    unsigned slot_count = 8;
+    while (slot_count < (unsigned)option_count * 2) {
+        slot_count <<= 1;
+    }
+    
+    int env_count = 0;
+    size_t trie_size = 1;
+    for (int i = 0; i < option_count; i++) {
+        env_count += options[i].env != NULL;
+        trie_size += options[i].long_name ? strlen(options[i].long_name) : 0;
+    }
+    unsigned env_slot_count = 0;
+    if (env_count > 0) {
+        env_slot_count = 8;
+        while (env_slot_count < (unsigned)env_count * 2) {
+            env_slot_count <<= 1;
+        }
+    }
+    
+    size_t words = presence_words(option_count);
+    OptionSpec *spec = mem_alloc(NULL, sizeof(OptionSpec) + sizeof(uint64_t) * words +
+                                 sizeof(SpecSlot) * (slot_count + env_slot_count) + sizeof(TrieNode) * trie_size);
+    if (!spec) {
+        return NULL;
+    }
+    spec->options = options;
+    spec->option_count = option_count;
+    spec->flags = flags;
+    spec->help_index = -1;
+    spec->mask = slot_count - 1;
+    spec->required = (uint64_t*)(spec + 1);
+    spec->slots = (SpecSlot*)(spec->required + words);
+    spec->name_lengths = 0;
+    spec->env_mask = env_slot_count ? env_slot_count - 1 : 0;
+    spec->env_slots = env_slot_count ? spec->slots + slot_count : NULL;
+    spec->env_lengths = 0;
+    spec->trie = (TrieNode*)(spec->slots + slot_count + env_slot_count);
+    spec->trie[0].child = -1;
+    spec->trie[0].sibling = -1;
+    spec->trie[0].option = -1;
+    spec->trie[0].only = -2;
+    spec->trie[0].c = 0;
+    spec->usage = NULL;
+    spec->usage_length = 0;
+    spec->usage_width = 0;
+    pthread_mutex_init(&spec->usage_lock, NULL);
+    memset(spec->required, 0, sizeof(uint64_t) * words);
+    for (unsigned i = 0; i < slot_count + env_slot_count; i++) {
+        spec->slots[i].index = -1;
+    }
+    for (int c = 0; c < 256; c++) {
+        spec->short_index[c] = -1;
+    }
+    
+    int help_short = -1;
+    int trie_count = 1;
+    for (int i = 0; i < option_count; i++) {
+        const char *name = options[i].long_name;
+        
+        if (options[i].type == OPT_FLAG) {
+            if (spec->help_index < 0 && name && strcmp(name, "help") == 0) {
+                spec->help_index = i;
+            } else if (help_short < 0 && options[i].short_name == 'h') {
+                help_short = i;
+            }
+        }
+        
+        if (options[i].required) {
+            spec->required[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+        
+        unsigned char short_name = (unsigned char)options[i].short_name;
+        if (short_name && spec->short_index[short_name] < 0) {
+            spec->short_index[short_name] = i;
+        }
+        
+        if (name) {
+            index_name(spec->slots, spec->mask, options, i, 0, &spec->name_lengths);
+            if (name[0]) {
+                trie_insert(spec->trie, &trie_count, name, i);
+            }
+        }
+        if (options[i].env) {
+            index_name(spec->env_slots, spec->env_mask, options, i, 1, &spec->env_lengths);
+        }
+    }
+    if (spec->help_index < 0) {
+        spec->help_index = help_short;
+    }
+    
+    return spec;
+}
+
+void cli_spec_free(OptionSpec *spec) {
+    if (spec) {
+        pthread_mutex_destroy(&spec->usage_lock);
+        mem_free(NULL, spec->usage);
+    }
+    mem_free(NULL, spec);
+}
+
+const Option *cli_spec_options(const OptionSpec *spec, int *option_count) {
+    if (option_count) {
+        *option_count = spec ? spec->option_count : 0;
+    }
+    return spec ? spec->options : NULL;
+}
+
+/* Internal helper functions */
+static Option* find_long_option(const OptionSpec *spec, const char *name, size_t len) {
+    return lookup_name(spec->slots, spec->mask, spec->options, 0, name, len);
+}
+
+static Option* find_env_option(const OptionSpec *spec, const char *name, size_t len) {
+    if (!spec->env_slots || !((spec->env_lengths >> (len < 63 ? len : 63)) & 1)) {
+        return NULL;
+    }
+    return lookup_name(spec->env_slots, spec->env_mask, spec->options, 1, name, len);
+}
+
+static int spec_has_length(const OptionSpec *spec, size_t len) {
+    return (spec->name_lengths >> (len < 63 ? len : 63)) & 1;
+}
+
+static Option* find_short_option(const OptionSpec *spec, char name) {
+    int index = spec->short_index[(unsigned char)name];
+    return index >= 0 ? &spec->options[index] : NULL;
+}
+
+/* Index of the one option whose long name starts with name, -1 if none, -2 if several */
+static int find_long_prefix(const OptionSpec *spec, const char *name, size_t len) {
+    int node = len > 0 ? trie_walk(spec->trie, name, len) : -1;
+    return node >= 0 ? spec->trie[node].only : -1;
+}
+
+/*
+ * Suggestions for a long name that did not match. If it is the start of
+ * some names, those are the candidates. Otherwise a Levenshtein row per
+ * trie depth is extended down the trie, and a subtree is dropped as soon
+ * as every entry of its row exceeds the bound, so only names near the
+ * input are ever visited.
+ */
+#define SUGGEST_MAX_LEN 32
+
+typedef struct {
+    const TrieNode *trie;
+    const char *name;
+    size_t len;
+    int bound;
+    int found;
+    int options[CLI_MAX_SUGGESTIONS];
+    int distances[CLI_MAX_SUGGESTIONS];
+    int rows[SUGGEST_MAX_LEN + 4][SUGGEST_MAX_LEN + 1];
+} Suggest;
+
+/* Keep the closest candidates; earlier (alphabetically smaller) ones win ties */
+static void suggest_add(Suggest *s, int option, int distance) {
+    int pos = s->found;
+    while (pos > 0 && s->distances[pos - 1] > distance) {
+        pos--;
+    }
+    if (pos >= CLI_MAX_SUGGESTIONS) {
+        return;
+    }
+    int last = s->found < CLI_MAX_SUGGESTIONS ? s->found : CLI_MAX_SUGGESTIONS - 1;
+    for (int k = last; k > pos; k--) {
+        s->options[k] = s->options[k - 1];
+        s->distances[k] = s->distances[k - 1];
+    }
+    s->options[pos] = option;
+    s->distances[pos] = distance;
+    if (s->found < CLI_MAX_SUGGESTIONS) {
+        s->found++;
+    }
+}
+
+/*
+ * Names below node, shortest first along each branch. Only branching
+ * recurses: the last child is followed in the loop, so a single long name
+ * costs no stack.
+ */
+static void suggest_completions(Suggest *s, int node) {
+    while (node >= 0 && s->found < CLI_MAX_SUGGESTIONS) {
+        if (s->trie[node].option >= 0) {
+            suggest_add(s, s->trie[node].option, 0);
+        }
+        int n = s->trie[node].child;
+        while (n >= 0 && s->trie[n].sibling >= 0 && s->found < CLI_MAX_SUGGESTIONS) {
+            suggest_completions(s, n);
+            n = s->trie[n].sibling;
+        }
+        node = n;
+    }
+}
+
+static void suggest_nearby(Suggest *s, int node, int depth) {
+    if (depth + 1 >= SUGGEST_MAX_LEN + 4) {
+        return;
+    }
+    const int *prev = s->rows[depth];
+    int *row = s->rows[depth + 1];
+    for (int n = s->trie[node].child; n >= 0; n = s->trie[n].sibling) {
+        row[0] = depth + 1;
+        int lowest = row[0];
+        for (size_t j = 1; j <= s->len; j++) {
+            int cost = prev[j - 1] + ((unsigned char)s->name[j - 1] != s->trie[n].c);
+            int insert = row[j - 1] + 1;
+            int remove = prev[j] + 1;
+            row[j] = cost < insert ? (cost < remove ? cost : remove) : (insert < remove ? insert : remove);
+            lowest = row[j] < lowest ? row[j] : lowest;
+        }
+        if (s->trie[n].option >= 0 && row[s->len] <= s->bound) {
+            suggest_add(s, s->trie[n].option, row[s->len]);
+        }
+        if (lowest <= s->bound) {
+            suggest_nearby(s, n, depth + 1);
+        }
+    }
+}
+
+static void suggest_long_names(const OptionSpec *spec, const char *name, size_t len, CliError *error) {
+    Suggest s;
+    s.trie = spec->trie;
+    s.name = name;
+    s.len = len;
+    s.bound = len < 5 ? 1 : 2;
+    s.found = 0;
+    
+    int node = trie_walk(spec->trie, name, len);
+    if (len > 0 && node >= 0) {
+        suggest_completions(&s, node);
+    }
+    if (s.found == 0 && len <= SUGGEST_MAX_LEN) {
+        for (size_t j = 0; j <= len; j++) {
+            s.rows[0][j] = (int)j;
+        }
+        suggest_nearby(&s, 0, 0);
+    }
+    for (int k = 0; k < s.found; k++) {
+        error->suggestions[k] = spec->options[s.options[k]].long_name;
+    }
+}
+
+/* State of one parse; nothing here is shared between parses */
+typedef struct {
+    const OptionSpec *spec;
+    ParseResult *result;
+    CliError *error;
+    char **argv;            /* NUL-terminated tokens, or NULL ... */
+    const StringView *views;/* ... when parsing read-only views instead */
+    int count;
+    int index;              /* index of the token being parsed */
+    PositionalCallback on_positional;  /* streams positionals instead of collecting them */
+    void *userdata;
+    OptionValue *values;    /* option values go here instead of Option.value */
+    LazyValue *lazy;        /* or raw values are recorded here, see set_value() */
+    const CliAllocator *allocator;  /* everything the result owns comes from here, NULL for malloc */
+    struct CliArena **arena;/* batch: positionals go into this arena */
+    const char *config_path;
+    const char *config_section;
+    char **env;             /* environment to read, NULL for none */
+    const char *env_prefix;
+    const char *source;     /* config file being applied, reported with errors ... */
+    int line;               /* ... along with the line in it */
+    struct TokenStream *stream;  /* argv is read from a descriptor, see stream_pull() */
+    unsigned *counts;       /* occurrences per option, or NULL */
+    uint64_t *present;      /* bit per option given; present_inline unless the table is large */
+    uint64_t present_inline[PRESENT_INLINE_WORDS];
+    int required_on_stop;   /* check required options when on_positional stops the parse */
+} Parser;
+
+/* Record that opt was given, from any source */
+static void mark_given(Parser *p, const Option *opt) {
+    size_t i = (size_t)(opt - p->spec->options);
+    p->present[i / 64] |= (uint64_t)1 << (i % 64);
+    if (p->counts) {
+        p->counts[i]++;
+    }
+}
+
+/* Where the value of opt is stored for this parse */
+static void *option_target(const Parser *p, const Option *opt) {
+    if (p->lazy) {
+        return &p->lazy[opt - p->spec->options].value;
+    }
+    return p->values ? (void*)&p->values[opt - p->spec->options] : opt->value;
+}
+
+static int parse_fail(Parser *p, CliErrorCode code, const char *message, const Option *opt) {
+    p->result->error = message;
+    p->error->code = code;
+    p->error->message = message;
+    p->error->index = p->index;
+    p->error->option = opt ? opt->long_name : NULL;
+    p->error->short_name = opt ? opt->short_name : 0;
+    p->error->source = p->source;
+    p->error->line = p->line;
+    return -1;
+}
+
+/*
+ * NUL-delimited argument stream (cli_parse_fd). Tokens are cut out of a
+ * chunk buffer with memchr() and handed to parse_tokens() one at a time,
+ * so it only ever looks at the current token and the one after it. When
+ * positionals are streamed the buffer is reused, and only values the result
+ * keeps are copied out (see keep_stream_value()); when they are collected
+ * every filled buffer is kept instead.
+ */
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
+struct TokenStream {
+    int fd;
+    char *buffer;
+    size_t size;
+    size_t length;          /* bytes read into buffer */
+    size_t pending;         /* start of the first token not handed out */
+    size_t scanned;         /* bytes from pending on known to hold no NUL */
+    int eof;
+    int failed;             /* read or allocation error, already reported */
+    int keep;               /* buffers stay with the result (positionals collected) */
+    char *tokens[2];        /* the current token and the one after it, by index & 1 */
+};
+
+static StringView token_at(const Parser *p, int i) {
+    if (p->stream) {
+        const char *data = p->stream->tokens[i & 1];
+        StringView token = {data, strlen(data)};
+        return token;
+    }
+    if (p->argv) {
+        StringView token = {p->argv[i], p->argv[i] ? strlen(p->argv[i]) : 0};
+        return token;
+    }
+    return p->views[i];
+}
+
+/*
+ * Numeric conversion. Integers, sizes and durations are parsed by hand on
+ * (pointer, length) text, independent of the locale. Doubles take an exact
+ * fast path when the decimal mantissa and power of ten are both exactly
+ * representable, and fall back to a correctly rounded strtod in the C locale.
+ */
+static const uint64_t eight_ones = 0x0101010101010101ULL;
+
+/* True when the 8 bytes loaded little-endian are all ASCII digits */
+static int is_eight_digits(uint64_t chunk) {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+             (((chunk + 0x06 * eight_ones) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x33 * eight_ones);
+}
+
+/* SWAR conversion of 8 ASCII digits (first digit in the lowest byte) */
+static uint32_t eight_digits_value(uint64_t chunk) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x30 * eight_ones;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)chunk;
+}
+
+static unsigned digit_value(char c) {
+    if (c >= '0' && c <= '9') return (unsigned)(c - '0');
+    if (c >= 'a' && c <= 'f') return (unsigned)(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return (unsigned)(c - 'A' + 10);
+    return 99;
+}
+
+/* Unsigned integer with an optional 0x, 0o or 0b prefix; all of s is used */
+static CliErrorCode parse_uint64(const char *s, size_t len, uint64_t *out) {
+    unsigned base = 10;
+    if (len > 2 && s[0] == '0') {
+        char prefix = (char)(s[1] | 0x20);
+        base = prefix == 'x' ? 16 : prefix == 'o' ? 8 : prefix == 'b' ? 2 : 10;
+        if (base != 10) {
+            s += 2;
+            len -= 2;
+        }
+    }
+    if (len == 0) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    
+    uint64_t value = 0;
+    size_t i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* Eight digits at a time while the result cannot overflow */
+    while (base == 10 && len - i >= 8 && value < 100000000000ULL) {
+        uint64_t chunk;
+        memcpy(&chunk, s + i, 8);
+        if (!is_eight_digits(chunk)) {
+            break;
+        }
+        value = value * 100000000ULL + eight_digits_value(chunk);
+        i += 8;
+    }
+#endif
+    for (; i < len; i++) {
+        unsigned digit = digit_value(s[i]);
+        if (digit >= base) {
+            return CLI_ERR_INVALID_VALUE;
+        }
+        if (value > (UINT64_MAX - digit) / base) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        value = value * base + digit;
+    }
+    *out = value;
+    return CLI_OK;
+}
+
+/* Signed integer in [min, max] */
+static CliErrorCode parse_int64(const char *s, size_t len, int64_t min, int64_t max, int64_t *out) {
+    int negative = len > 0 && s[0] == '-';
+    if (len > 0 && (s[0] == '-' || s[0] == '+')) {
+        s++;
+        len--;
+    }
+    
+    uint64_t magnitude;
+    CliErrorCode code = parse_uint64(s, len, &magnitude);
+    if (code != CLI_OK) {
+        return code;
+    }
+    
+    int64_t value;
+    if (negative) {
+        if (magnitude > (uint64_t)INT64_MAX + 1) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        value = magnitude == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)magnitude;
+    } else {
+        if (magnitude > (uint64_t)INT64_MAX) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        value = (int64_t)magnitude;
+    }
+    if (value < min || value > max) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+    *out = value;
+    return CLI_OK;
+}
+
+#ifdef SMARTARGS_HAVE_STRTOD_L
+/* The C locale for strtod_l(), created once and kept for the process */
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+static locale_t c_locale;
+
+static void make_c_locale(void) {
+    c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+#endif
+
+/*
+ * Correctly rounded fallback; text must be NUL-terminated at len. Overflow and
+ * underflow are both range errors, as with plain strtod(). Without strtod_l()
+ * this follows the process locale, so a program that calls setlocale() reads
+ * long doubles with its decimal separator.
+ */
+static CliErrorCode strtod_c_locale(const char *text, size_t len, double *out) {
+    char *end;
+#ifdef SMARTARGS_HAVE_STRTOD_L
+    pthread_once(&c_locale_once, make_c_locale);
+    errno = 0;
+    double value = c_locale ? strtod_l(text, &end, c_locale) : strtod(text, &end);
+    int range_error = errno == ERANGE;
+#else
+    errno = 0;
+    double value = strtod(text, &end);
+    int range_error = errno == ERANGE;
+#endif
+    if (range_error) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+    if (end != text + len || len == 0) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    *out = value;
+    return CLI_OK;
+}
+
+/*
+ * Double. text is s NUL-terminated, or NULL if no terminated copy exists;
+ * then only the fast path is available.
+ */
+static CliErrorCode parse_double(const char *s, size_t len, const char *text, double *out) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    size_t i = 0;
+    int negative = 0;
+    if (i < len && (s[i] == '-' || s[i] == '+')) {
+        negative = s[i] == '-';
+        i++;
+    }
+    
+    /* Decimal mantissa of at most 19 significant digits, and its exponent */
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int digits = 0;
+    int truncated = 0;
+    long exponent = 0;
+    for (; i < len && s[i] >= '0' && s[i] <= '9'; i++, digits++) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+            significant += mantissa != 0;
+        } else {
+            exponent++;
+            truncated |= s[i] != '0';
+        }
+    }
+    if (i < len && s[i] == '.') {
+        for (i++; i < len && s[i] >= '0' && s[i] <= '9'; i++, digits++) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+                significant += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= s[i] != '0';
+            }
+        }
+    }
+    if (digits > 0 && i < len && (s[i] == 'e' || s[i] == 'E')) {
+        size_t j = i + 1;
+        int exp_negative = j < len && s[j] == '-';
+        if (j < len && (s[j] == '-' || s[j] == '+')) {
+            j++;
+        }
+        long exp_value = 0;
+        size_t exp_start = j;
+        for (; j < len && s[j] >= '0' && s[j] <= '9'; j++) {
+            if (exp_value < 100000) {
+                exp_value = exp_value * 10 + (s[j] - '0');
+            }
+        }
+        if (j > exp_start) {
+            exponent += exp_negative ? -exp_value : exp_value;
+            i = j;
+        }
+    }
+    
+    if (digits > 0 && i == len && !truncated &&
+        mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        /* Both operands are exact, so one IEEE operation rounds correctly */
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+        *out = negative ? -value : value;
+        return CLI_OK;
+    }
+    
+    /* Long mantissas, large exponents, inf/nan and hex floats */
+    if (!text) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    return strtod_c_locale(text, len, out);
+}
+
+/* Size with an optional binary suffix: 512, 64k, 512M, 2GiB, 1TB */
+static CliErrorCode parse_size(const char *s, size_t len, uint64_t *out) {
+    size_t digits = 0;
+    int prefixed = len > 2 && s[0] == '0' && ((s[1] | 0x20) == 'x' || (s[1] | 0x20) == 'b' ||
+                                              (s[1] | 0x20) == 'o');
+    if (prefixed) {
+        digits = len;  /* no suffixes after a base prefix, 0x1B is a number */
+    } else {
+        while (digits < len && s[digits] >= '0' && s[digits] <= '9') {
+            digits++;
+        }
+    }
+    
+    uint64_t value;
+    CliErrorCode code = parse_uint64(s, digits, &value);
+    if (code != CLI_OK) {
+        return code;
+    }
+    
+    const char *suffix = s + digits;
+    size_t suffix_len = len - digits;
+    int shift = 0;
+    if (suffix_len > 0) {
+        static const char units[] = "kmgtpe";
+        const char *unit = memchr(units, suffix[0] | 0x20, sizeof(units) - 1);
+        if (unit) {
+            shift = 10 * (int)(unit - units + 1);
+            suffix++;
+            suffix_len--;
+            if (suffix_len > 0 && suffix[0] == 'i') {
+                suffix++;
+                suffix_len--;
+                if (suffix_len == 0) {
+                    return CLI_ERR_INVALID_VALUE;
+                }
+            }
+        }
+        if (suffix_len == 1 && (suffix[0] == 'B' || suffix[0] == 'b')) {
+            suffix_len = 0;
+        }
+        if (suffix_len != 0) {
+            return CLI_ERR_INVALID_VALUE;
+        }
+    }
+    if (shift && value > (UINT64_MAX >> shift)) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+    *out = value << shift;
+    return CLI_OK;
+}
+
+/* Duration in nanoseconds: 250ms, 1.5s, 1h30m, 90 (seconds) */
+static CliErrorCode parse_duration(const char *s, size_t len, int64_t *out) {
+    static const struct { const char *name; size_t len; uint64_t ns; } units[] = {
+        {"ns", 2, 1ULL}, {"us", 2, 1000ULL}, {"\xc2\xb5s", 3, 1000ULL}, {"ms", 2, 1000000ULL},
+        {"s", 1, 1000000000ULL}, {"m", 1, 60000000000ULL}, {"h", 1, 3600000000000ULL},
+        {"d", 1, 86400000000000ULL}
+    };
+    size_t i = 0;
+    int negative = len > 0 && s[0] == '-';
+    if (len > 0 && (s[0] == '-' || s[0] == '+')) {
+        i++;
+    }
+    if (i == len) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    
+    uint64_t total = 0;
+    while (i < len) {
+        /* Integer and fraction digits */
+        size_t start = i;
+        while (i < len && s[i] >= '0' && s[i] <= '9') {
+            i++;
+        }
+        uint64_t whole = 0;
+        if (i > start) {
+            CliErrorCode code = parse_uint64(s + start, i - start, &whole);
+            if (code != CLI_OK) {
+                return code;
+            }
+        }
+        const char *fraction = NULL;
+        size_t fraction_len = 0;
+        if (i < len && s[i] == '.') {
+            fraction = s + ++i;
+            while (i < len && s[i] >= '0' && s[i] <= '9') {
+                i++;
+            }
+            fraction_len = (size_t)(s + i - fraction);
+        }
+        if (i == start || (i - start == 1 && fraction)) {
+            return CLI_ERR_INVALID_VALUE;
+        }
+        
+        /* Unit; a lone number without one means seconds */
+        uint64_t unit = 0;
+        for (size_t u = 0; u < sizeof(units) / sizeof(units[0]); u++) {
+            if (len - i >= units[u].len && memcmp(s + i, units[u].name, units[u].len) == 0 &&
+                (units[u].len > 1 || i + 1 == len || s[i + 1] < 'a' || s[i + 1] > 'z')) {
+                unit = units[u].ns;
+                i += units[u].len;
+                break;
+            }
+        }
+        if (!unit) {
+            if (i != len || start != (size_t)(s[0] == '-' || s[0] == '+')) {
+                return CLI_ERR_INVALID_VALUE;
+            }
+            unit = units[4].ns;
+        }
+        
+        if (whole > ((uint64_t)INT64_MAX - total) / unit) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        total += whole * unit;
+        uint64_t scale = unit;
+        for (size_t f = 0; f < fraction_len && scale >= 10; f++) {
+            scale /= 10;
+            uint64_t part = (uint64_t)(fraction[f] - '0') * scale;
+            if (part > (uint64_t)INT64_MAX - total) {
+                return CLI_ERR_OUT_OF_RANGE;
+            }
+            total += part;
+        }
+    }
+    *out = negative ? -(int64_t)total : (int64_t)total;
+    return CLI_OK;
+}
+
+/*
+ * Views are not terminated; the strtod fallback gets a stack copy, which also
+ * keeps it from reading past the view.
+ */
+#define NUMBER_BUFFER_SIZE 128
+
+static const char *number_text(int terminated, StringView value, char *buffer) {
+    if (terminated) {
+        return value.data;
+    }
+    if (value.length >= NUMBER_BUFFER_SIZE) {
+        return NULL;
+    }
+    memcpy(buffer, value.data, value.length);
+    buffer[value.length] = '\0';
+    return buffer;
+}
+
+/* Messages per numeric type: missing, invalid, out of range */
+static const char *number_message(OptionType type, CliErrorCode code) {
+    int kind = code == CLI_ERR_MISSING_VALUE ? 0 : code == CLI_ERR_INVALID_VALUE ? 1 : 2;
+    switch (type) {
+        case OPT_DOUBLE: {
+            static const char *m[] = {"Double option requires a value", "Invalid double value",
+                                      "Double value out of range"};
+            return m[kind];
+        }
+        case OPT_SIZE: {
+            static const char *m[] = {"Size option requires a value", "Invalid size value",
+                                      "Size value out of range"};
+            return m[kind];
+        }
+        case OPT_DURATION: {
+            static const char *m[] = {"Duration option requires a value", "Invalid duration value",
+                                      "Duration value out of range"};
+            return m[kind];
+        }
+        default: {
+            static const char *m[] = {"Integer option requires a value", "Invalid integer value",
+                                      "Integer value out of range"};
+            return m[kind];
+        }
+    }
+}
+
+/* Convert value into target, which has the type of opt */
+static int convert_number(Parser *p, const Option *opt, StringView value, int terminated, void *target) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    CliErrorCode code = CLI_OK;
+    int64_t i64 = 0;
+    uint64_t u64 = 0;
+    double d = 0;
+    
+    if (!value.data) {
+        code = CLI_ERR_MISSING_VALUE;
+    } else {
+        switch (opt->type) {
+            case OPT_INT:
+                code = parse_int64(value.data, value.length, INT_MIN, INT_MAX, &i64);
+                if (code == CLI_OK) *(int*)target = (int)i64;
+                break;
+            case OPT_COUNT:
+                code = parse_int64(value.data, value.length, 0, INT_MAX, &i64);
+                if (code == CLI_OK) *(int*)target = (int)i64;
+                break;
+            case OPT_INT64:
+                code = parse_int64(value.data, value.length, INT64_MIN, INT64_MAX, &i64);
+                if (code == CLI_OK) *(int64_t*)target = i64;
+                break;
+            case OPT_UINT64:
+                if (value.length > 0 && value.data[0] == '-') {
+                    code = parse_uint64(value.data + 1, value.length - 1, &u64);
+                    code = code != CLI_OK ? code : u64 ? CLI_ERR_OUT_OF_RANGE : CLI_OK;
+                } else {
+                    size_t sign = value.length > 0 && value.data[0] == '+';
+                    code = parse_uint64(value.data + sign, value.length - sign, &u64);
+                }
+                if (code == CLI_OK) *(uint64_t*)target = u64;
+                break;
+            case OPT_SIZE:
+                code = parse_size(value.data, value.length, &u64);
+                if (code == CLI_OK && u64 > SIZE_MAX) code = CLI_ERR_OUT_OF_RANGE;
+                if (code == CLI_OK) *(size_t*)target = (size_t)u64;
+                break;
+            case OPT_DURATION:
+                code = parse_duration(value.data, value.length, &i64);
+                if (code == CLI_OK) *(int64_t*)target = i64;
+                break;
+            default:
+                code = parse_double(value.data, value.length, number_text(terminated, value, buffer), &d);
+                if (code == CLI_OK) *(double*)target = d;
+                break;
+        }
+    }
+    
+    if (code != CLI_OK) {
+        return parse_fail(p, code, number_message(opt->type, code), opt);
+    }
+    return 0;
+}
+
+static int set_number(Parser *p, Option *opt, StringView value) {
+    return convert_number(p, opt, value, p->argv != NULL, option_target(p, opt));
+}
+
+static int set_list(Parser *p, Option *opt, StringView value);
+static int keep_stream_value(Parser *p, Option *opt, StringView *value);
+
+static int is_scalar(OptionType type) {
+    return type != OPT_FLAG && type != OPT_COUNT && type != OPT_INT_LIST && type != OPT_DOUBLE_LIST &&
+           type != OPT_STRING_LIST;
+}
+
+enum { LAZY_UNSET, LAZY_RAW, LAZY_CONVERTED };  /* LazyValue.state */
+
+/*
+ * Lazy parse: a scalar value is only checked for presence and its slice
+ * recorded, each occurrence overwriting the last; cli_get_value() converts
+ * the winner. Flags and lists, which accumulate, are applied as usual.
+ */
+static int record_value(Parser *p, Option *opt, StringView value) {
+    LazyValue *lazy = &p->lazy[opt - p->spec->options];
+    
+    if (is_scalar(opt->type)) {
+        if (!value.data) {
+            const char *message = opt->type == OPT_STRING || opt->type == OPT_STRING_VIEW ?
+                                  "String option requires a value" :
+                                  number_message(opt->type, CLI_ERR_MISSING_VALUE);
+            return parse_fail(p, CLI_ERR_MISSING_VALUE, message, opt);
+        }
+        if (opt->type == OPT_STRING && !p->argv) {
+            return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS,
+                              "String option needs STRING_VIEW when parsing views", opt);
+        }
+    }
+    if (!is_scalar(opt->type) && p->stream && !p->stream->keep && !p->source) {
+        value.data = NULL;      /* the token is about to be reused */
+        value.length = 0;
+    }
+    lazy->raw = value;
+    lazy->type = opt->type;
+    lazy->long_name = opt->long_name;
+    lazy->index = p->index;
+    lazy->source = p->source;
+    lazy->line = p->line;
+    lazy->terminated = p->argv != NULL;
+    lazy->state = is_scalar(opt->type) ? LAZY_RAW : LAZY_CONVERTED;
+    return 0;
+}
+
+static int set_value(Parser *p, Option *opt, StringView value) {
+    void *target = option_target(p, opt);
+    
+    mark_given(p, opt);
+    if (keep_stream_value(p, opt, &value) != 0) {
+        return -1;
+    }
+    if (p->lazy) {
+        int ret = record_value(p, opt, value);
+        if (ret != 0 || is_scalar(opt->type)) {
+            return ret;
+        }
+    }
+    switch (opt->type) {
+        case OPT_FLAG:
+            *(int*)target = 1;
+            return 0;
+            
+        case OPT_INT:
+        case OPT_INT64:
+        case OPT_UINT64:
+        case OPT_SIZE:
+        case OPT_DURATION:
+        case OPT_DOUBLE:
+        case OPT_COUNT: {
+            STAT_CLOCK(convert_started);
+            int ret = set_number(p, opt, value);
+            STAT_ELAPSED(convert_ns, convert_started);
+            return ret;
+        }
+        
+        case OPT_STRING:
+            if (!value.data) {
+                return parse_fail(p, CLI_ERR_MISSING_VALUE, "String option requires a value", opt);
+            }
+            if (!p->argv) {
+                return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS,
+                                  "String option needs STRING_VIEW when parsing views", opt);
+            }
+            *(const char**)target = value.data;
+            return 0;
+            
+        case OPT_STRING_VIEW:
+            if (!value.data) {
+                return parse_fail(p, CLI_ERR_MISSING_VALUE, "String option requires a value", opt);
+            }
+            *(StringView*)target = value;
+            return 0;
+            
+        case OPT_INT_LIST:
+        case OPT_DOUBLE_LIST:
+        case OPT_STRING_LIST: {
+            STAT_CLOCK(convert_started);
+            int ret = set_list(p, opt, value);
+            STAT_ELAPSED(convert_ns, convert_started);
+            return ret;
+        }
+            
+        default:
+            return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS, "Unknown option type", opt);
+    }
+}
+
+/* Bump allocator backing batch results; blocks are only freed all together */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN(n) (((n) + 15) & ~(size_t)15)
+
+struct CliArena {
+    struct CliArena *next;
+    size_t used;
+    size_t size;
+};
+
+static void *arena_alloc(struct CliArena **arena, size_t size) {
+    const size_t header = ARENA_ALIGN(sizeof(struct CliArena));
+    struct CliArena *block = *arena;
+    
+    size = ARENA_ALIGN(size);
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = mem_alloc(NULL, header + block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->used = 0;
+        block->size = block_size;
+        block->next = *arena;
+        *arena = block;
+    }
+    void *ptr = (char*)block + header + block->used;
+    block->used += size;
+    return ptr;
+}
+
+static void arena_free(struct CliArena *arena) {
+    while (arena) {
+        struct CliArena *next = arena->next;
+        mem_free(NULL, arena);
+        arena = next;
+    }
+}
+
+/*
+ * Caller's bump arena (CliBumpArena). Each block is preceded by its size so
+ * that realloc() knows how much to copy; the latest block grows in place,
+ * which is how positionals and list items grow during a parse.
+ */
+#define BUMP_HEADER ARENA_ALIGN(sizeof(size_t))
+
+static void *bump_alloc(void *userdata, size_t size) {
+    CliBumpArena *arena = userdata;
+    size_t available = arena->size - arena->used;
+    
+    if (size > available || BUMP_HEADER + ARENA_ALIGN(size) > available) {
+        return NULL;
+    }
+    char *block = arena->base + arena->used + BUMP_HEADER;
+    *(size_t*)(block - BUMP_HEADER) = size;
+    arena->used += BUMP_HEADER + ARENA_ALIGN(size);
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return block;
+}
+
+static int bump_is_last(const CliBumpArena *arena, const char *block) {
+    size_t size = *(const size_t*)(block - BUMP_HEADER);
+    return block + ARENA_ALIGN(size) == arena->base + arena->used;
+}
+
+static void *bump_realloc(void *userdata, void *ptr, size_t size) {
+    CliBumpArena *arena = userdata;
+    char *block = ptr;
+    
+    if (!block) {
+        return bump_alloc(arena, size);
+    }
+    size_t old_size = *(size_t*)(block - BUMP_HEADER);
+    if (bump_is_last(arena, block)) {
+        size_t start = (size_t)(block - arena->base);
+        if (size > arena->size - start || ARENA_ALIGN(size) > arena->size - start) {
+            return NULL;
+        }
+        *(size_t*)(block - BUMP_HEADER) = size;
+        arena->used = start + ARENA_ALIGN(size);
+        if (arena->used > arena->peak) {
+            arena->peak = arena->used;
+        }
+        return block;
+    }
+    char *moved = bump_alloc(arena, size);
+    if (moved) {
+        memcpy(moved, block, old_size < size ? old_size : size);
+    }
+    return moved;
+}
+
+static void bump_free(void *userdata, void *ptr) {
+    CliBumpArena *arena = userdata;
+    char *block = ptr;
+    
+    if (bump_is_last(arena, block)) {
+        arena->used = (size_t)(block - BUMP_HEADER - arena->base);
+    }
+}
+
+int cli_arena_init(CliBumpArena *arena, void *buffer, size_t size) {
+    memset(arena, 0, sizeof(CliBumpArena));
+    if (!buffer) {
+        buffer = malloc(size ? size : 1);
+        if (!buffer) {
+            return -1;
+        }
+        arena->owned = buffer;
+    }
+    /* Blocks are aligned for any value the parser stores */
+    size_t skew = ARENA_ALIGN((uintptr_t)buffer) - (uintptr_t)buffer;
+    arena->base = (char*)buffer + (skew < size ? skew : size);
+    arena->size = size - (skew < size ? skew : size);
+    arena->allocator.alloc = bump_alloc;
+    arena->allocator.realloc = bump_realloc;
+    arena->allocator.free = bump_free;
+    arena->allocator.userdata = arena;
+    return 0;
+}
+
+void cli_arena_reset(CliBumpArena *arena) {
+    arena->used = 0;
+}
+
+void cli_arena_destroy(CliBumpArena *arena) {
+    free(arena->owned);  /* base may be past it, aligned */
+    memset(arena, 0, sizeof(CliBumpArena));
+}
+
+/* Capacity is implied by the count: 4, then doubled at each power of two */
+static int grow_positionals(Parser *p, void **array, size_t item_size) {
+    int count = p->result->arg_count;
+    if (count == 0 || (count >= 4 && (count & (count - 1)) == 0)) {
+        size_t capacity = count ? (size_t)count * 2 : 4;
+        void *new_array = mem_realloc(p->allocator, *array, item_size * capacity);
+        if (!new_array) {
+            return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+        }
+        *array = new_array;
+    }
+    return 0;
+}
+
+/* Returns 1 when a positional callback asked to stop */
+static int add_positional(Parser *p, StringView arg) {
+    ParseResult *result = p->result;
+    
+    if (p->on_positional) {
+        return p->on_positional(arg, p->userdata) != 0 ? 1 : 0;
+    }
+    if (p->arena) {
+        /* Batch: one arena array sized for every token being positional */
+        if (!result->args) {
+            result->args = arena_alloc(p->arena, sizeof(char*) * (size_t)p->count);
+            if (!result->args) {
+                return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+            }
+            result->args_borrowed = 1;
+        }
+        result->args[result->arg_count++] = (char*)arg.data;
+    } else if (p->argv) {
+        if (grow_positionals(p, (void**)&result->args, sizeof(char*)) != 0) {
+            return -1;
+        }
+        result->args[result->arg_count++] = (char*)arg.data;
+    } else {
+        if (grow_positionals(p, (void**)&result->arg_views, sizeof(StringView)) != 0) {
+            return -1;
+        }
+        result->arg_views[result->arg_count++] = arg;
+    }
+    return 0;
+}
+
+/*
+ * CLI_PERMUTE: move the option group argv[start..end] in front of the
+ * positionals seen so far, so they stay contiguous and in order. A group
+ * is at most an option and its separate value.
+ */
+static void permute_group(char *argv[], int *first_positional, int start, int end) {
+    int group_len = end - start + 1;
+    int block_len = start - *first_positional;
+    
+    if (block_len > 0) {
+        char *group[2];
+        memcpy(group, argv + start, sizeof(char*) * group_len);
+        memmove(argv + *first_positional + group_len, argv + *first_positional,
+                sizeof(char*) * block_len);
+        memcpy(argv + *first_positional, group, sizeof(char*) * group_len);
+    }
+    *first_positional += group_len;
+}
+
+/* Memory owned by a ParseResult besides args: mappings and heap blocks */
+struct CliResource {
+    struct CliResource *next;
+    void *addr;
+    size_t map_size;        /* length of an mmap'd region, 0 for heap blocks */
+    const Option *list;     /* list option whose items these are, or NULL ... */
+    const char *source;     /* ... and the p->source that last wrote them */
+    const Option *value_of; /* scalar option whose stream value this copy holds, or NULL */
+};
+
+static int own_resource(Parser *p, void *addr, size_t map_size) {
+    struct CliResource *res = mem_alloc(p->allocator, sizeof(struct CliResource));
+    if (!res) {
+        return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+    }
+    res->addr = addr;
+    res->map_size = map_size;
+    res->list = NULL;
+    res->source = NULL;
+    res->value_of = NULL;
+    res->next = p->result->resources;
+    p->result->resources = res;
+    return 0;
+}
+
+/*
+ * List options. Each list is one heap block owned by the result; its
+ * capacity is implied by the count: 8, then doubled at each power of two.
+ */
+static size_t list_capacity(size_t count) {
+    size_t capacity = 8;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/*
+ * Room for extra more items after *count in the list of opt. Items from
+ * an earlier source, or not allocated by this parse at all, are dropped
+ * first by setting *count to 0. Returns the (possibly moved) items.
+ */
+static void *list_reserve(Parser *p, const Option *opt, size_t *count, size_t extra, size_t item_size) {
+    struct CliResource *res = p->result->resources;
+    while (res && res->list != opt) {
+        res = res->next;
+    }
+    if (!res || res->source != p->source) {
+        *count = 0;
+    }
+    if (extra > SIZE_MAX / item_size / 2 - *count) {
+        parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", opt);
+        return NULL;
+    }
+    
+    size_t needed = *count + extra;
+    if (!res || *count == 0 || list_capacity(*count) < needed) {
+        void *items = mem_realloc(p->allocator, res ? res->addr : NULL, item_size * list_capacity(needed));
+        if (!items) {
+            parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", opt);
+            return NULL;
+        }
+        if (!res) {
+            if (own_resource(p, items, 0) != 0) {
+                mem_free(p->allocator, items);
+                return NULL;
+            }
+            res = p->result->resources;
+            res->list = opt;
+        }
+        res->addr = items;
+    }
+    res->source = p->source;
+    return res->addr;
+}
+
+/* Commas in s[0..len), eight bytes at a time */
+static size_t count_commas(const char *s, size_t len) {
+    const uint64_t high = 0x7F7F7F7F7F7F7F7FULL;
+    size_t commas = 0;
+    size_t i = 0;
+    for (; len - i >= 8; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, s + i, 8);
+        uint64_t x = chunk ^ (',' * eight_ones);
+        /* Top bit set in exactly the zero bytes of x, then summed across bytes */
+        uint64_t zero = ~(((x & high) + high) | x | high);
+        commas += (size_t)(((zero >> 7) * eight_ones) >> 56);
+    }
+    for (; i < len; i++) {
+        commas += s[i] == ',';
+    }
+    return commas;
+}
+
+/*
+ * Comma-separated numbers are appended in one pass: the commas size the
+ * buffer once, then each field is converted in place. Strings are never
+ * split, since that would mean writing to argv.
+ */
+static int set_list(Parser *p, Option *opt, StringView value) {
+    void *target = option_target(p, opt);
+    
+    if (opt->type == OPT_STRING_LIST) {
+        if (!value.data) {
+            return parse_fail(p, CLI_ERR_MISSING_VALUE, "String option requires a value", opt);
+        }
+        if (!p->argv) {
+            return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS,
+                              "String list option cannot be used when parsing views", opt);
+        }
+        StringList *list = target;
+        const char **items = list_reserve(p, opt, &list->count, 1, sizeof(const char*));
+        if (!items) {
+            return -1;
+        }
+        list->items = items;
+        items[list->count++] = value.data;
+        return 0;
+    }
+    
+    int doubles = opt->type == OPT_DOUBLE_LIST;
+    OptionType element = doubles ? OPT_DOUBLE : OPT_INT;
+    if (!value.data) {
+        return parse_fail(p, CLI_ERR_MISSING_VALUE, number_message(element, CLI_ERR_MISSING_VALUE), opt);
+    }
+    
+    size_t extra = count_commas(value.data, value.length) + 1;
+    size_t *count = doubles ? &((DoubleList*)target)->count : &((IntList*)target)->count;
+    void *items = list_reserve(p, opt, count, extra, doubles ? sizeof(double) : sizeof(int));
+    if (!items) {
+        return -1;
+    }
+    if (doubles) {
+        ((DoubleList*)target)->items = items;
+    } else {
+        ((IntList*)target)->items = items;
+    }
+    
+    const char *field = value.data;
+    const char *end = value.data + value.length;
+    size_t n = *count;
+    for (;;) {
+        const char *comma = memchr(field, ',', (size_t)(end - field));
+        size_t len = (size_t)((comma ? comma : end) - field);
+        CliErrorCode code;
+        if (doubles) {
+            /* Fields are not terminated; the strtod fallback gets a copy */
+            char buffer[NUMBER_BUFFER_SIZE];
+            const char *text = NULL;
+            if (len < NUMBER_BUFFER_SIZE) {
+                memcpy(buffer, field, len);
+                buffer[len] = '\0';
+                text = buffer;
+            }
+            code = parse_double(field, len, text, (double*)items + n);
+        } else {
+            int64_t i64 = 0;
+            code = parse_int64(field, len, INT_MIN, INT_MAX, &i64);
+            ((int*)items)[n] = (int)i64;
+        }
+        if (code != CLI_OK) {
+            return parse_fail(p, code, number_message(element, code), opt);
+        }
+        n++;
+        if (!comma) {
+            break;
+        }
+        field = comma + 1;
+    }
+    *count = n;
+    return 0;
+}
+
+static void release_resources(struct CliResource **list, const CliAllocator *allocator) {
+    while (*list) {
+        struct CliResource *res = *list;
+        *list = res->next;
+        if (res->map_size) {
+            munmap(res->addr, res->map_size);
+        } else {
+            mem_free(allocator, res->addr);
+        }
+        mem_free(allocator, res);
+    }
+}
+
+/*
+ * @response files, gcc style. Each file is mapped privately with one spare
+ * byte and tokenized in place, so every token is a NUL-terminated slice of
+ * the mapping. The mappings live until cli_free().
+ */
+#define MAX_RESPONSE_DEPTH 16
+#define MAX_RESPONSE_FILES 1024 /* per parse, so files naming each other twice stay linear */
+
+typedef struct {
+    Parser *p;
+    int literal;            /* set after "--": later tokens are not expanded */
+    int files;              /* @files opened so far */
+    int count;
+    int capacity;
+    char **argv;            /* expanded tokens in argv mode ... */
+    StringView *views;      /* ... or in view mode */
+} Expansion;
+
+static int append_token(Expansion *exp, StringView token) {
+    if (exp->count == exp->capacity) {
+        int capacity = exp->capacity ? exp->capacity * 2 : 64;
+        if (exp->p->argv) {
+            char **grown = mem_realloc(exp->p->allocator, exp->argv, sizeof(char*) * capacity);
+            if (!grown) {
+                return parse_fail(exp->p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+            }
+            exp->argv = grown;
+        } else {
+            StringView *grown = mem_realloc(exp->p->allocator, exp->views, sizeof(StringView) * capacity);
+            if (!grown) {
+                return parse_fail(exp->p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+            }
+            exp->views = grown;
+        }
+        exp->capacity = capacity;
+    }
+    if (exp->p->argv) {
+        exp->argv[exp->count++] = (char*)token.data;
+    } else {
+        exp->views[exp->count++] = token;
+    }
+    return 0;
+}
+
+/*
+ * With a caller's allocator, files are read into its memory instead of
+ * mapped, so that every byte of the parse is within its budget. Closes fd.
+ */
+static int read_private_file(Parser *p, int fd, size_t len, char **data, size_t *size) {
+    char *base = len < SIZE_MAX ? mem_alloc(p->allocator, len + 1) : NULL;
+    if (!base) {
+        close(fd);
+        return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+    }
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, base + done, len - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            close(fd);
+            mem_free(p->allocator, base);
+            return 1;
+        }
+        if (n == 0) {
+            break;          /* truncated since fstat() */
+        }
+        done += (size_t)n;
+    }
+    close(fd);
+    base[done] = '\0';
+    
+    if (own_resource(p, base, 0) != 0) {
+        mem_free(p->allocator, base);
+        return -1;
+    }
+    *data = base;
+    *size = done;
+    return 0;
+}
+
+/*
+ * Map a regular file privately with at least one zeroed spare byte after
+ * it, so its contents can be NUL-terminated in place. Returns 1 if the file
+ * cannot be opened or mapped, with errno from open() when that failed.
+ */
+static int map_private_file(Parser *p, const char *path, char **data, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 1;
+    }
+    
+    size_t len = (size_t)st.st_size;
+    if (p->allocator) {
+        return read_private_file(p, fd, len, data, size);
+    }
+    
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_size = (len + 1 + page - 1) / page * page;
+    
+    /* Reserve zeroed pages, then place the file over the front of them */
+    char *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+    }
+    if (len > 0 && mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, map_size);
+        close(fd);
+        return 1;
+    }
+    close(fd);
+    
+    if (own_resource(p, base, map_size) != 0) {
+        munmap(base, map_size);
+        return -1;
+    }
+    *data = base;
+    *size = len;
+    return 0;
+}
+
+static int expand_token(Expansion *exp, StringView token, int depth);
+
+static int expand_response_file(Expansion *exp, StringView token, int depth) {
+    Parser *p = exp->p;
+    char path_buffer[PATH_MAX];
+    const char *path = token.data + 1;
+    
+    if (!p->argv) {
+        if (token.length > sizeof(path_buffer)) {
+            return append_token(exp, token);
+        }
+        memcpy(path_buffer, path, token.length - 1);
+        path_buffer[token.length - 1] = '\0';
+        path = path_buffer;
+    }
+    if (depth >= MAX_RESPONSE_DEPTH) {
+        return parse_fail(p, CLI_ERR_RESPONSE_FILE, "Response files nested too deeply", NULL);
+    }
+    if (++exp->files > MAX_RESPONSE_FILES) {
+        return parse_fail(p, CLI_ERR_RESPONSE_FILE, "Too many response files", NULL);
+    }
+    
+    char *data;
+    size_t size;
+    int ret = map_private_file(p, path, &data, &size);
+    if (ret != 0) {
+        /* Like gcc, an unreadable @file is kept as a literal argument */
+        return ret > 0 ? append_token(exp, token) : -1;
+    }
+    
+    /* Whitespace separates; quotes group; backslash escapes the next character */
+    size_t r = 0;
+    while (r < size) {
+        while (r < size && (data[r] == ' ' || data[r] == '\t' || data[r] == '\n' ||
+                            data[r] == '\r' || data[r] == '\f' || data[r] == '\v')) {
+            r++;
+        }
+        if (r >= size) {
+            break;
+        }
+        
+        char *start = data + r;
+        char *w = start;
+        char quote = 0;
+        for (; r < size; r++) {
+            char c = data[r];
+            if (c == '\\' && r + 1 < size) {
+                *w++ = data[++r];
+            } else if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                } else {
+                    *w++ = c;
+                }
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+                break;
+            } else {
+                *w++ = c;
+            }
+        }
+        r++;  /* step over the separator before it can be overwritten */
+        *w = '\0';  /* w <= data + size, and data[size] is the spare byte */
+        
+        StringView piece = {start, (size_t)(w - start)};
+        if (expand_token(exp, piece, depth + 1) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int expand_token(Expansion *exp, StringView token, int depth) {
+    if (!exp->literal && token.data && token.length > 1 && token.data[0] == '@') {
+        return expand_response_file(exp, token, depth);
+    }
+    if (token.data && token.length == 2 && token.data[0] == '-' && token.data[1] == '-') {
+        exp->literal = 1;
+    }
+    return append_token(exp, token);
+}
+
+/* Replace the tokens of p by their expansion if any of them is an @file */
+static int expand_response_files(Parser *p) {
+    int found = 0;
+    for (int i = 1; i < p->count && !found; i++) {
+        StringView token = token_at(p, i);
+        found = token.data && token.length > 1 && token.data[0] == '@';
+    }
+    if (!found) {
+        return 0;
+    }
+    
+    Expansion exp = {p, 0, 0, 0, 0, NULL, NULL};
+    int ret = 0;
+    for (int i = 0; i < p->count && ret == 0; i++) {
+        p->index = i;
+        StringView token = token_at(p, i);
+        ret = i == 0 ? append_token(&exp, token) : expand_token(&exp, token, 0);
+    }
+    
+    void *array = p->argv ? (void*)exp.argv : (void*)exp.views;
+    if (ret != 0 || own_resource(p, array, 0) != 0) {
+        mem_free(p->allocator, array);
+        return -1;
+    }
+    p->argv = exp.argv;
+    p->views = exp.views;
+    p->count = exp.count;
+    return 0;
+}
+
+/*
+ * INI config file, applied before the command line so that argv wins.
+ * Top-level keys and those in [config_section] apply; other sections are
+ * skipped a line at a time without looking inside them. A key is only
+ * hashed if some long option name has its length, unknown keys are
+ * ignored, and values are NUL-terminated in the private mapping.
+ */
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int config_flag(const char *value, size_t len) {
+    static const char *const names[] = {"1", "true", "yes", "on", "0", "false", "no", "off"};
+    for (int i = 0; i < 8; i++) {
+        if (strlen(names[i]) == len && strncasecmp(value, names[i], len) == 0) {
+            return i < 4;
+        }
+    }
+    return -1;
+}
+
+/* Set opt from text outside argv: flags take a boolean word there */
+static int apply_text(Parser *p, Option *opt, StringView value) {
+    if (opt->type == OPT_FLAG) {
+        int flag = config_flag(value.data, value.length);
+        if (flag < 0) {
+            return parse_fail(p, CLI_ERR_INVALID_VALUE, "Invalid flag value", opt);
+        }
+        if (p->lazy && record_value(p, opt, value) != 0) {
+            return -1;
+        }
+        mark_given(p, opt);
+        *(int*)option_target(p, opt) = flag;
+        return 0;
+    }
+    return set_value(p, opt, value);
+}
+
+static int apply_config(Parser *p) {
+    char *data;
+    size_t size;
+    
+    errno = 0;
+    int ret = map_private_file(p, p->config_path, &data, &size);
+    if (ret != 0) {
+        if (ret > 0 && errno == ENOENT) {
+            return 0;
+        }
+        p->source = p->config_path;
+        return ret > 0 ? parse_fail(p, CLI_ERR_CONFIG_FILE, "Cannot read config file", NULL) : -1;
+    }
+    p->source = p->config_path;
+    
+    char *end = data + size;
+    char *c = data;
+    while (c < end) {
+        char *eol = memchr(c, '\n', (size_t)(end - c));
+        if (!eol) {
+            eol = end;
+        }
+        p->line++;
+        while (c < eol && is_blank(*c)) {
+            c++;
+        }
+        
+        if (c < eol && *c == '[') {
+            char *close = memchr(c, ']', (size_t)(eol - c));
+            if (!close) {
+                return parse_fail(p, CLI_ERR_CONFIG_FILE, "Malformed config line", NULL);
+            }
+            const char *name = c + 1;
+            while (name < close && is_blank(*name)) {
+                name++;
+            }
+            while (close > name && is_blank(close[-1])) {
+                close--;
+            }
+            size_t name_len = (size_t)(close - name);
+            int active = p->config_section && strlen(p->config_section) == name_len &&
+                         memcmp(p->config_section, name, name_len) == 0;
+            
+            /* Skip to the next line that starts a section */
+            c = eol + 1;
+            while (!active && c < end) {
+                const char *first = c;
+                while (first < end && is_blank(*first)) {
+                    first++;
+                }
+                if (first < end && *first == '[') {
+                    break;
+                }
+                eol = memchr(c, '\n', (size_t)(end - c));
+                c = eol ? eol + 1 : end;
+                p->line++;
+            }
+            continue;
+        }
+        if (c == eol || *c == '#' || *c == ';') {
+            c = eol + 1;
+            continue;
+        }
+        
+        char *equals = memchr(c, '=', (size_t)(eol - c));
+        if (!equals) {
+            return parse_fail(p, CLI_ERR_CONFIG_FILE, "Malformed config line", NULL);
+        }
+        char *key_end = equals;
+        while (key_end > c && is_blank(key_end[-1])) {
+            key_end--;
+        }
+        size_t key_len = (size_t)(key_end - c);
+        
+        Option *opt = NULL;
+        if (spec_has_length(p->spec, key_len)) {
+            opt = find_long_option(p->spec, c, key_len);
+        }
+        if (opt) {
+            char *value = equals + 1;
+            char *value_end = eol;
+            while (value < value_end && is_blank(*value)) {
+                value++;
+            }
+            while (value_end > value && is_blank(value_end[-1])) {
+                value_end--;
+            }
+            if (value_end - value >= 2 && *value == '"' && value_end[-1] == '"') {
+                value++;
+                value_end--;
+            }
+            *value_end = '\0';
+            StringView view = {value, (size_t)(value_end - value)};
+            if (apply_text(p, opt, view) != 0) {
+                return -1;
+            }
+        }
+        c = eol + 1;
+    }
+    
+    p->source = NULL;
+    p->line = 0;
+    return 0;
+}
+
+/* Option named by env_prefix + NAME, with NAME an upper-case long name using _ for - */
+static Option *find_prefixed_option(const Parser *p, const char *name, size_t len) {
+    char buffer[128];
+    if (len >= sizeof(buffer) || !spec_has_length(p->spec, len)) {
+        return NULL;
+    }
+    
+    int underscores = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        underscores |= c == '_';
+        buffer[i] = c == '_' ? '-' : (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    Option *opt = find_long_option(p->spec, buffer, len);
+    if (!opt && underscores) {
+        for (size_t i = 0; i < len; i++) {
+            buffer[i] = buffer[i] == '-' ? '_' : buffer[i];
+        }
+        opt = find_long_option(p->spec, buffer, len);
+    }
+    /* An option that names its own variable is only read from that one */
+    return opt && !opt->env ? opt : NULL;
+}
+
+/*
+ * Environment fallback, applied after the config file and before argv.
+ * One pass over the environment resolves every option: each entry is
+ * looked up in the hashed env names of the spec, then, if it carries
+ * env_prefix, as a long name.
+ */
+static int apply_env(Parser *p) {
+    size_t prefix_len = p->env_prefix ? strlen(p->env_prefix) : 0;
+    if (!p->spec->env_slots && prefix_len == 0) {
+        return 0;
+    }
+    
+    for (char **entry = p->env; *entry; entry++) {
+        const char *equals = strchr(*entry, '=');
+        if (!equals) {
+            continue;
+        }
+        size_t name_len = (size_t)(equals - *entry);
+        
+        Option *opt = find_env_option(p->spec, *entry, name_len);
+        if (!opt && prefix_len && name_len > prefix_len &&
+            memcmp(*entry, p->env_prefix, prefix_len) == 0) {
+            opt = find_prefixed_option(p, *entry + prefix_len, name_len - prefix_len);
+        }
+        if (opt) {
+            StringView value = {equals + 1, strlen(equals + 1)};
+            p->source = *entry;
+            if (apply_text(p, opt, value) != 0) {
+                return -1;
+            }
+        }
+    }
+    p->source = NULL;
+    return 0;
+}
+
+/*
+ * A reused stream buffer is overwritten by the next chunk, so values the
+ * result keeps (strings, string list items and lazy scalars) are copied out.
+ * Switches, numbers and the tokens after them are not. A scalar's copy is
+ * reused by its next occurrence, so repeating an option adds nothing.
+ */
+static int keep_stream_value(Parser *p, Option *opt, StringView *value) {
+    int scalar = is_scalar(opt->type);
+    if (!p->stream || p->stream->keep || p->source || !value->data ||
+        (opt->type != OPT_STRING && opt->type != OPT_STRING_VIEW && opt->type != OPT_STRING_LIST &&
+         !(p->lazy && scalar))) {
+        return 0;
+    }
+    
+    struct CliResource *res = NULL;
+    if (scalar) {
+        for (res = p->result->resources; res && res->value_of != opt; res = res->next) {
+        }
+    }
+    char *copy;
+    if (res) {
+        copy = mem_realloc(p->allocator, res->addr, value->length + 1);
+        if (!copy) {
+            return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", opt);
+        }
+        res->addr = copy;
+    } else {
+        copy = mem_alloc(p->allocator, value->length + 1);
+        if (!copy) {
+            return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", opt);
+        }
+        if (own_resource(p, copy, 0) != 0) {
+            mem_free(p->allocator, copy);
+            return -1;
+        }
+        p->result->resources->value_of = scalar ? opt : NULL;
+    }
+    memcpy(copy, value->data, value->length);
+    copy[value->length] = '\0';
+    value->data = copy;
+    return 0;
+}
+
+/* Room for more input: the partial token moves to the front or to a new buffer */
+static int stream_make_room(Parser *p, struct TokenStream *s) {
+    size_t partial = s->length - s->pending;
+    size_t size = STREAM_CHUNK_SIZE;
+    while (partial + 1 >= size) {
+        size *= 2;
+    }
+    
+    if (s->buffer && !s->keep) {
+        memmove(s->buffer, s->buffer + s->pending, partial);
+        if (size > s->size) {
+            char *grown = mem_realloc(p->allocator, s->buffer, size);
+            if (!grown) {
+                return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+            }
+            s->buffer = grown;
+            s->size = size;
+        }
+    } else {
+        /* Kept buffers never move: tokens already handed out point into them */
+        char *fresh = mem_alloc(p->allocator, size);
+        if (!fresh) {
+            return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+        }
+        if (s->keep && own_resource(p, fresh, 0) != 0) {
+            mem_free(p->allocator, fresh);
+            return -1;
+        }
+        if (partial > 0) {
+            memcpy(fresh, s->buffer + s->pending, partial);
+        }
+        s->buffer = fresh;
+        s->size = size;
+    }
+    s->length = partial;
+    s->pending = 0;
+    return 0;
+}
+
+/* Make token p->count available; 0 at the end of the stream or on error */
+static int stream_pull(Parser *p) {
+    struct TokenStream *s = p->stream;
+    if (!s || s->failed) {
+        return 0;
+    }
+    
+    char *token;
+    size_t len;
+    for (;;) {
+        if (s->buffer) {
+            token = s->buffer + s->pending;
+            char *nul = memchr(token + s->scanned, '\0', s->length - s->pending - s->scanned);
+            if (nul) {
+                len = (size_t)(nul - token);
+                break;
+            }
+            s->scanned = s->length - s->pending;
+            if (s->eof) {
+                if (s->scanned == 0) {
+                    return 0;
+                }
+                len = s->scanned;
+                token[len] = '\0';  /* last token without a terminator; reads leave a spare byte */
+                break;
+            }
+        }
+        /* Refill: only once the buffer is full, so a chunk is read with one call */
+        if ((!s->buffer || s->length + 1 >= s->size) && stream_make_room(p, s) != 0) {
+            s->failed = 1;
+            return 0;
+        }
+        ssize_t n = read(s->fd, s->buffer + s->length, s->size - 1 - s->length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            s->failed = 1;
+            parse_fail(p, CLI_ERR_INVALID_ARGUMENTS, "Cannot read argument stream", NULL);
+            return 0;
+        }
+        s->eof = n == 0;
+        s->length += (size_t)n;
+    }
+    s->pending = s->pending + len < s->length ? s->pending + len + 1 : s->length;
+    s->scanned = 0;
+    
+    s->tokens[p->count & 1] = token;
+    p->count++;
+    return 1;
+}
+
+/* Take the next token as the value of opt */
+static int next_value(Parser *p, int *i, const Option *opt, StringView *value) {
+    if (*i + 1 >= p->count && !stream_pull(p)) {
+        if (p->stream && p->stream->failed) {
+            return -1;
+        }
+        return parse_fail(p, CLI_ERR_MISSING_VALUE, "Option requires a value", opt);
+    }
+    *value = token_at(p, ++*i);
+    p->index = *i;
+    STAT_ADD(tokens, 1);
+    return 0;
+}
+
+/* Fails on the first required option of p's table that was not given */
+static int check_required(Parser *p) {
+    const OptionSpec *spec = p->spec;
+    
+    /* Skip the check if help was requested */
+    STAT_CLOCK(required_started);
+    int help_requested = spec->help_index >= 0 &&
+                         *(int*)option_target(p, &spec->options[spec->help_index]) != 0;
+    int ret = 0;
+    
+    if (!help_requested) {
+        size_t words = presence_words(spec->option_count);
+        for (size_t w = 0; w < words; w++) {
+            uint64_t missing = spec->required[w] & ~p->present[w];
+            if (missing) {
+                int bit = 0;
+                while (!(missing & ((uint64_t)1 << bit))) {
+                    bit++;
+                }
+                ret = parse_fail(p, CLI_ERR_REQUIRED_MISSING, "Required option missing",
+                                 &spec->options[w * 64 + (size_t)bit]);
+                break;
+            }
+        }
+    }
+    STAT_ELAPSED(required_ns, required_started);
+    
+    return ret;
+}
+
+/* A flag or count given on the command line */
+static void set_switch(Parser *p, Option *opt, StringView arg) {
+    int *target = option_target(p, opt);
+    
+    if (p->lazy) {
+        record_value(p, opt, arg);
+    }
+    mark_given(p, opt);
+    if (opt->type == OPT_FLAG) {
+        *target = 1;
+    } else if (*target < INT_MAX) {
+        (*target)++;
+    }
+}
+
+/* The option and positional tokens of p, after argv[0] */
+static int scan_tokens(Parser *p) {
+    const OptionSpec *spec = p->spec;
+    ParseResult *result = p->result;
+    CliError *error = p->error;
+    Option *options = spec->options;
+    int permute = p->argv && !p->stream && !p->on_positional && (spec->flags & CLI_PERMUTE) != 0;
+    int first_positional = 1;
+    
+    for (int i = 1; i < p->count || stream_pull(p); i++) {
+        StringView arg = token_at(p, i);
+        const char *data = arg.data;
+        int start = i;
+        p->index = i;
+        STAT_ADD(tokens, 1);
+        
+        if (!data) {
+            return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS, "NULL argument encountered", NULL);
+        }
+        
+#ifdef SMARTARGS_STATS
+        /* Hidden flag: print the stats of this thread after the parse */
+        if (arg.length == 17 && memcmp(data, "--smartargs-trace", 17) == 0) {
+            thread_trace = 1;
+            if (permute) {
+                permute_group(p->argv, &first_positional, i, i);
+            }
+            continue;
+        }
+#endif
+        
+        /* Handle -- (end of options) */
+        if (arg.length == 2 && data[0] == '-' && data[1] == '-') {
+            if (permute) {
+                permute_group(p->argv, &first_positional, i, i);
+                break;
+            }
+            for (int j = i + 1; j < p->count || stream_pull(p); j++) {
+                p->index = j;
+                int ret = add_positional(p, token_at(p, j));
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            break;
+        }
+        
+        /* Long option --name or --name=value, matched on the prefix before = */
+        if (arg.length > 2 && data[0] == '-' && data[1] == '-') {
+            const char *name = data + 2;
+            const char *equals = memchr(name, '=', arg.length - 2);
+            size_t name_len = equals ? (size_t)(equals - name) : arg.length - 2;
+            
+            Option *opt = find_long_option(spec, name, name_len);
+            if (!opt && (spec->flags & CLI_PREFIX_MATCH)) {
+                int index = find_long_prefix(spec, name, name_len);
+                if (index == -2) {
+                    parse_fail(p, CLI_ERR_AMBIGUOUS_OPTION, "Ambiguous option", NULL);
+                    suggest_long_names(spec, name, name_len, error);
+                    return -1;
+                }
+                opt = index >= 0 ? &options[index] : NULL;
+            }
+            if (!opt) {
+                parse_fail(p, CLI_ERR_UNKNOWN_OPTION, "Unknown option", NULL);
+                suggest_long_names(spec, name, name_len, error);
+                return -1;
+            }
+            
+            if (opt->type == OPT_FLAG || opt->type == OPT_COUNT) {
+                if (equals) {
+                    return parse_fail(p, CLI_ERR_UNEXPECTED_VALUE, "Flag option does not accept a value", opt);
+                }
+                set_switch(p, opt, arg);
+            } else {
+                StringView value;
+                if (equals) {
+                    value.data = equals + 1;
+                    value.length = arg.length - (size_t)(value.data - data);
+                } else if (next_value(p, &i, opt, &value) != 0) {
+                    return -1;
+                }
+                if (set_value(p, opt, value) != 0) {
+                    return -1;
+                }
+            }
+        }
+        /* Short options: -x, bundled flags -abc, attached values -t8 */
+        else if (arg.length > 1 && data[0] == '-' && data[1] != '-') {
+            for (size_t c = 1; c < arg.length; c++) {
+                Option *opt = find_short_option(spec, data[c]);
+                if (!opt) {
+                    parse_fail(p, CLI_ERR_UNKNOWN_OPTION, "Unknown option", NULL);
+                    error->short_name = data[c];
+                    return -1;
+                }
+                
+                if (opt->type == OPT_FLAG || opt->type == OPT_COUNT) {
+                    set_switch(p, opt, arg);
+                    continue;
+                }
+                
+                /* The rest of the token is the value, otherwise the next argument */
+                StringView value = {data + c + 1, arg.length - c - 1};
+                if (value.length == 0 && next_value(p, &i, opt, &value) != 0) {
+                    return -1;
+                }
+                if (set_value(p, opt, value) != 0) {
+                    return -1;
+                }
+                break;
+            }
+        }
+        /* Positional argument, left in place when permuting */
+        else {
+            if (!permute) {
+                int ret = add_positional(p, arg);
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            continue;
+        }
+        
+        if (permute) {
+            permute_group(p->argv, &first_positional, start, i);
+        }
+    }
+    
+    if (permute) {
+        result->args = p->argv + first_positional;
+        result->arg_count = p->count - first_positional;
+        result->args_borrowed = 1;
+    }
+    if (p->stream && p->stream->failed) {
+        return -1;
+    }
+    p->index = -1;
+    return 0;
+}
+
+/* Config, environment and tokens, then the required check; p->present is ready */
+static int parse_sources(Parser *p) {
+    const OptionSpec *spec = p->spec;
+    
+    memset(p->present, 0, sizeof(uint64_t) * presence_words(spec->option_count));
+    if (p->counts) {
+        memset(p->counts, 0, sizeof(unsigned) * (size_t)spec->option_count);
+    }
+    if (p->lazy) {
+        memset(p->lazy, 0, sizeof(LazyValue) * (size_t)spec->option_count);
+    }
+    if (p->stream && p->count == 0 && !stream_pull(p) && p->stream->failed) {
+        return -1;          /* the stream starts with argv[0] */
+    }
+    if ((spec->flags & CLI_RESPONSE_FILES) && !p->stream && expand_response_files(p) != 0) {
+        return -1;
+    }
+    p->index = -1;
+    if (p->config_path && apply_config(p) != 0) {
+        return -1;
+    }
+    if (p->env && apply_env(p) != 0) {
+        return -1;
+    }
+    
+    STAT_SCAN_BEGIN();
+    int ret = scan_tokens(p);
+    STAT_SCAN_END();
+    
+    if (ret == 0 || (ret == 1 && p->required_on_stop)) {
+        return check_required(p) != 0 ? -1 : ret;
+    }
+    return ret;
+}
+
+/* Parse the tokens of p; nothing in them is ever written */
+static int parse_tokens(Parser *p) {
+    const OptionSpec *spec = p->spec;
+    ParseResult *result = p->result;
+    CliError *error = p->error;
+    
+    /* Initialize result */
+    memset(result, 0, sizeof(ParseResult));
+    memset(error, 0, sizeof(CliError));
+    error->index = -1;
+    result->allocator = p->allocator;
+    
+    if (!spec || (!p->argv && !p->views) || p->count < 0) {
+        return parse_fail(p, CLI_ERR_INVALID_ARGUMENTS, "Invalid arguments", NULL);
+    }
+    
+    /* The presence bits are scratch for this parse, not part of the result */
+    size_t words = presence_words(spec->option_count);
+    p->present = p->present_inline;
+    if (words > PRESENT_INLINE_WORDS) {
+        p->present = mem_alloc(p->allocator, sizeof(uint64_t) * words);
+        if (!p->present) {
+            return parse_fail(p, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+        }
+    }
+    
+    int ret = parse_sources(p);
+    if (p->present != p->present_inline) {
+        mem_free(p->allocator, p->present);
+    }
+    p->present = NULL;
+    return ret;
+}
+
+static int parse_argv(const OptionSpec *spec, int argc, char *argv[],
+                      ParseResult *result, CliError *error) {
+    Parser parser = {0};
+    parser.spec = spec;
+    parser.result = result;
+    parser.error = error;
+    parser.argv = argv;
+    parser.count = argc;
+    parser.index = -1;
+    parser.env = environ;
+    return trace_parse(parse_tokens(&parser));
+}
+
+/* Parser writing to a context and streaming through its callback, if any */
+static Parser context_parser(ParseContext *ctx, const OptionSpec *spec) {
+    Parser parser = {0};
+    parser.spec = spec;
+    parser.result = &ctx->result;
+    parser.error = &ctx->error;
+    parser.index = -1;
+    parser.on_positional = ctx->on_positional;
+    parser.userdata = ctx->userdata;
+    parser.values = ctx->values;
+    parser.lazy = ctx->lazy;
+    parser.counts = ctx->counts;
+    parser.allocator = ctx->allocator;
+    parser.config_path = ctx->config_path;
+    parser.config_section = ctx->config_section;
+    parser.env = ctx->environment ? ctx->environment : environ;
+    parser.env_prefix = ctx->env_prefix;
+    return parser;
+}
+
+int cli_parse(int argc, char *argv[], Option *options, int option_count, ParseResult *result) {
+    if (!argv || !options || !result || argc < 0 || option_count < 0) {
+        if (result) result->error = "Invalid arguments";
+        return -1;
+    }
+    
+    OptionSpec *spec = cli_compile(options, option_count);
+    if (!spec) {
+        memset(result, 0, sizeof(ParseResult));
+        result->error = "Memory allocation failed";
+        return -1;
+    }
+    
+    int ret = cli_parse_spec(spec, argc, argv, result);
+    cli_spec_free(spec);
+    return ret;
+}
+
+int cli_parse_spec(const OptionSpec *spec, int argc, char *argv[], ParseResult *result) {
+    CliError error;
+    
+    if (!result) {
+        return -1;
+    }
+    return parse_argv(spec, argc, argv, result, &error);
+}
+
+int cli_parse_ctx(ParseContext *ctx, const OptionSpec *spec, int argc, char *argv[]) {
+    if (!ctx) {
+        return -1;
+    }
+    Parser parser = context_parser(ctx, spec);
+    parser.argv = argv;
+    parser.count = argc;
+    return trace_parse(parse_tokens(&parser));
+}
+
+int cli_parse_fd(ParseContext *ctx, const OptionSpec *spec, int fd, const char *program_name) {
+    if (!ctx) {
+        return -1;
+    }
+    struct TokenStream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.fd = fd;
+    stream.keep = !ctx->on_positional;
+    
+    Parser parser = context_parser(ctx, spec);
+    parser.stream = &stream;
+    parser.argv = stream.tokens;
+    parser.count = 0;
+    if (program_name) {
+        stream.tokens[0] = (char*)program_name;
+        parser.count = 1;
+    }
+    int ret = parse_tokens(&parser);
+    if (!stream.keep) {
+        mem_free(parser.allocator, stream.buffer);
+    }
+    return trace_parse(ret);
+}
+
+int cli_parse_views(ParseContext *ctx, const OptionSpec *spec, int count, const StringView tokens[]) {
+    if (!ctx) {
+        return -1;
+    }
+    Parser parser = context_parser(ctx, spec);
+    parser.views = tokens;
+    parser.count = count;
+    return trace_parse(parse_tokens(&parser));
+}
+
+int cli_configure_ctx(ParseContext *ctx, int argc, char *argv[], Option *options, int option_count,
+                      const char *description) {
+    if (!ctx) {
+        return -1;
+    }
+    
+    OptionSpec *spec = cli_compile(options, option_count);
+    if (!spec) {
+        memset(&ctx->result, 0, sizeof(ParseResult));
+        memset(&ctx->error, 0, sizeof(CliError));
+        ctx->result.error = ctx->error.message = "Memory allocation failed";
+        ctx->error.code = CLI_ERR_NO_MEMORY;
+        ctx->error.index = -1;
+        return -1;
+    }
+    
+    int ret = cli_parse_ctx(ctx, spec, argc, argv);
+    int help = spec->help_index;
+    if (ret == 0 && help >= 0 &&
+        (ctx->lazy ? ctx->lazy[help].value.i :
+         ctx->values ? ctx->values[help].i : *(int*)options[help].value)) {
+        cli_spec_usage(spec, argc > 0 ? argv[0] : NULL, description);
+        ret = 1;
+    }
+    cli_spec_free(spec);
+    return ret;
+}
+
+void cli_ctx_free(ParseContext *ctx) {
+    if (ctx) {
+        cli_free(&ctx->result);
+    }
+}
+
+/*
+ * Accessors for a lazy parse. A value is converted on its first read, with
+ * errors reported as the eager parse would have, and cached after that.
+ * They work from the type and name recorded in the LazyValue, as the
+ * option table may be gone by then (TRY_ARGS keeps it in its own block).
+ */
+static Option lazy_option(const LazyValue *lazy) {
+    Option opt = {0};
+    opt.long_name = lazy->long_name;
+    opt.type = lazy->type;
+    return opt;
+}
+
+int cli_get_value(ParseContext *ctx, int option, OptionValue *value) {
+    if (!ctx || !ctx->lazy || option < 0) {
+        return -1;
+    }
+    LazyValue *lazy = &ctx->lazy[option];
+    if (lazy->state == LAZY_RAW) {
+        Parser parser = {0};
+        parser.result = &ctx->result;
+        parser.error = &ctx->error;
+        parser.index = lazy->index;
+        parser.source = lazy->source;
+        parser.line = lazy->line;
+        
+        Option opt = lazy_option(lazy);
+        if (opt.type == OPT_STRING) {
+            lazy->value.s = lazy->raw.data;
+        } else if (opt.type == OPT_STRING_VIEW) {
+            lazy->value.view = lazy->raw;
+        } else {
+            STAT_CLOCK(convert_started);
+            int ret = convert_number(&parser, &opt, lazy->raw, lazy->terminated, &lazy->value);
+            STAT_ELAPSED(convert_ns, convert_started);
+            if (ret != 0) {
+                return -1;
+            }
+        }
+        lazy->state = LAZY_CONVERTED;
+    }
+    if (lazy->state == LAZY_UNSET) {
+        return 0;
+    }
+    if (value) {
+        *value = lazy->value;
+    }
+    return 1;
+}
+
+/* The converted value of an option of one of two types; both the same for one */
+static int get_typed(ParseContext *ctx, int option, OptionType type, OptionType alias, OptionValue *value) {
+    int ret = cli_get_value(ctx, option, value);
+    if (ret > 0 && ctx->lazy[option].type != type && ctx->lazy[option].type != alias) {
+        Parser parser = {0};
+        parser.result = &ctx->result;
+        parser.error = &ctx->error;
+        parser.index = -1;
+        Option opt = lazy_option(&ctx->lazy[option]);
+        return parse_fail(&parser, CLI_ERR_INVALID_ARGUMENTS, "Option read as the wrong type", &opt);
+    }
+    return ret;
+}
+
+int cli_get_flag(ParseContext *ctx, int option, int *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_FLAG, OPT_FLAG, &v);
+    if (ret > 0) *value = v.i;
+    return ret;
+}
+
+int cli_get_int(ParseContext *ctx, int option, int *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_INT, OPT_COUNT, &v);
+    if (ret > 0) *value = v.i;
+    return ret;
+}
+
+int cli_get_int64(ParseContext *ctx, int option, int64_t *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_INT64, OPT_DURATION, &v);
+    if (ret > 0) *value = v.i64;
+    return ret;
+}
+
+int cli_get_uint64(ParseContext *ctx, int option, uint64_t *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_UINT64, OPT_UINT64, &v);
+    if (ret > 0) *value = v.u64;
+    return ret;
+}
+
+int cli_get_size(ParseContext *ctx, int option, size_t *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_SIZE, OPT_SIZE, &v);
+    if (ret > 0) *value = v.size;
+    return ret;
+}
+
+int cli_get_double(ParseContext *ctx, int option, double *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_DOUBLE, OPT_DOUBLE, &v);
+    if (ret > 0) *value = v.d;
+    return ret;
+}
+
+int cli_get_string(ParseContext *ctx, int option, const char **value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_STRING, OPT_STRING, &v);
+    if (ret > 0) *value = v.s;
+    return ret;
+}
+
+int cli_get_view(ParseContext *ctx, int option, StringView *value) {
+    OptionValue v;
+    int ret = get_typed(ctx, option, OPT_STRING_VIEW, OPT_STRING_VIEW, &v);
+    if (ret > 0) *value = v.view;
+    return ret;
+}
+
+/*
+ * Subcommands. The command names are compiled as a table of flags, so
+ * dispatch is a hashed lookup and an unknown name gets the suggestions of
+ * an unknown long option. Command tables are compiled on first use.
+ */
+struct CommandSet {
+    OptionSpec *global;
+    Command *commands;
+    int command_count;
+    Option *names;          /* one flag per command, named after it */
+    OptionSpec *index;      /* compiled names */
+    pthread_mutex_t lock;
+    OptionSpec **specs;     /* per command, NULL until selected; guarded by lock */
+};
+
+CommandSet *cli_commands_compile(Option *global, int global_count, Command *commands, int command_count) {
+    if (!global || global_count < 0 || !commands || command_count < 0) {
+        return NULL;
+    }
+    for (int i = 0; i < command_count; i++) {
+        if (!commands[i].name || !commands[i].name[0] || commands[i].option_count < 0 ||
+            (!commands[i].options && commands[i].option_count > 0)) {
+            return NULL;
+        }
+    }
+    
+    CommandSet *set = mem_alloc(NULL, sizeof(CommandSet) + sizeof(Option) * (size_t)command_count +
+                                sizeof(OptionSpec*) * (size_t)command_count);
+    if (!set) {
+        return NULL;
+    }
+    set->commands = commands;
+    set->command_count = command_count;
+    set->names = (Option*)(set + 1);
+    set->specs = (OptionSpec**)(set->names + command_count);
+    for (int i = 0; i < command_count; i++) {
+        Option name = {commands[i].name, 0, OPT_FLAG, NULL, NULL, 0, NULL};
+        set->names[i] = name;
+        set->specs[i] = NULL;
+    }
+    set->global = cli_compile(global, global_count);
+    set->index = cli_compile(set->names, command_count);
+    if (!set->global || !set->index) {
+        cli_spec_free(set->global);
+        cli_spec_free(set->index);
+        mem_free(NULL, set);
+        return NULL;
+    }
+    pthread_mutex_init(&set->lock, NULL);
+    return set;
+}
+
+void cli_commands_free(CommandSet *set) {
+    if (set) {
+        for (int i = 0; i < set->command_count; i++) {
+            cli_spec_free(set->specs[i]);
+        }
+        cli_spec_free(set->global);
+        cli_spec_free(set->index);
+        pthread_mutex_destroy(&set->lock);
+    }
+    mem_free(NULL, set);
+}
+
+const OptionSpec *cli_command_spec(const CommandSet *set, int command) {
+    if (!set || command < 0 || command >= set->command_count) {
+        return NULL;
+    }
+    CommandSet *shared = (CommandSet*)set;
+    pthread_mutex_lock(&shared->lock);
+    if (!shared->specs[command]) {
+        /* A command without options still needs a (empty) table */
+        const Command *c = &set->commands[command];
+        shared->specs[command] = cli_compile(c->options ? c->options : shared->names, c->option_count);
+    }
+    OptionSpec *spec = shared->specs[command];
+    pthread_mutex_unlock(&shared->lock);
+    return spec;
+}
+
+/* The first positional ends the global options: it names the command */
+static int stop_at_command(StringView arg, void *userdata) {
+    (void)arg;
+    (void)userdata;
+    return 1;
+}
+
+int cli_parse_command(ParseContext *ctx, const CommandSet *set, int argc, char *argv[]) {
+    if (!ctx) {
+        return -1;
+    }
+    memset(&ctx->result, 0, sizeof(ParseResult));
+    
+    Parser parser = context_parser(ctx, set ? set->global : NULL);
+    parser.values = NULL;
+    parser.lazy = NULL;
+    parser.counts = NULL;
+    parser.on_positional = stop_at_command;
+    parser.required_on_stop = 1;
+    parser.argv = argv;
+    parser.count = argc;
+    int ret = parse_tokens(&parser);
+    if (ret <= 0) {
+        return trace_parse(ret) == 0 ? CLI_NO_COMMAND : -1;
+    }
+    
+    /* parser.argv is the expanded vector if the global table reads response files */
+    int offset = parser.index;
+    const char *name = parser.argv[offset];
+    size_t len = strlen(name);
+    Option *found = lookup_name(set->index->slots, set->index->mask, set->names, 0, name, len);
+    if (!found) {
+        parse_fail(&parser, CLI_ERR_UNKNOWN_COMMAND, "Unknown command", NULL);
+        suggest_long_names(set->index, name, len, &ctx->error);
+        return trace_parse(-1);
+    }
+    int command = (int)(found - set->names);
+    const OptionSpec *spec = cli_command_spec(set, command);
+    if (!spec) {
+        parse_fail(&parser, CLI_ERR_NO_MEMORY, "Memory allocation failed", NULL);
+        return trace_parse(-1);
+    }
+    
+    /* The command's parse starts a new result; keep what the global one holds */
+    struct CliResource *held = ctx->result.resources;
+    ret = cli_parse_ctx(ctx, spec, parser.count - offset, parser.argv + offset);
+    struct CliResource **tail = &ctx->result.resources;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = held;
+    if (ret < 0) {
+        if (ctx->error.index >= 0) {
+            ctx->error.index += offset;
+        }
+        return -1;
+    }
+    return command;
+}
+
+/*
+ * Snapshot cache. A snapshot holds the final values of the options a
+ * successful parse was given and the argv indexes of its positionals,
+ * keyed by everything that parse read: the option table, argv, the
+ * identity of the config file and the environment. Loading maps the
+ * file privately and patches offsets into pointers in place, so strings
+ * and list items are used straight from the mapping, which the result owns.
+ */
+#define SNAPSHOT_MAGIC "SASNAP2"
+#define SNAPSHOT_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+typedef struct {
+    char magic[8];
+    uint64_t key;
+    uint64_t size;          /* of the whole file */
+    uint32_t option_count;
+    uint32_t arg_count;
+    uint64_t args;          /* offset of arg_count argv indexes, patched into char* */
+    uint64_t inputs;        /* offset of the snapshot_inputs() bytes the key hashes */
+    uint64_t inputs_size;
+} SnapshotHeader;
+
+/* One per option, right after the header */
+typedef struct {
+    uint32_t count;         /* occurrences, 0 if not given */
+    uint32_t type;
+    uint64_t a;             /* scalar bits, or offset of the string or items */
+    uint64_t b;             /* string length or item count */
+} SnapshotValue;
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} SnapshotBuffer;
+
+/* Room for end bytes in b; 0 once anything failed */
+static int snapshot_reserve(SnapshotBuffer *b, size_t end) {
+    if (b->failed) {
+        return 0;
+    }
+    if (end > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity : 4096;
+        while (capacity < end) {
+            capacity *= 2;
+        }
+        char *grown = mem_realloc(NULL, b->data, capacity);
+        if (!grown) {
+            b->failed = 1;
+            return 0;
+        }
+        b->data = grown;
+        b->capacity = capacity;
+    }
+    return 1;
+}
+
+/* Append len bytes (zeros if data is NULL) at an aligned offset, which is returned */
+static uint64_t snapshot_put(SnapshotBuffer *b, const void *data, size_t len) {
+    size_t offset = SNAPSHOT_ALIGN(b->length);
+    if (!snapshot_reserve(b, offset + len)) {
+        return 0;
+    }
+    memset(b->data + b->length, 0, offset - b->length);
+    if (data && len > 0) {
+        memcpy(b->data + offset, data, len);
+    } else {
+        memset(b->data + offset, 0, len);
+    }
+    b->length = offset + len;
+    return offset;
+}
+
+/* The string and a terminator, which the zeroed space provides */
+static uint64_t snapshot_put_string(SnapshotBuffer *b, const char *data, size_t len) {
+    uint64_t offset = snapshot_put(b, NULL, len + 1);
+    if (!b->failed && len > 0) {
+        memcpy(b->data + offset, data, len);
+    }
+    return offset;
+}
+
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len) {
+    const unsigned char *c = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= c[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Inputs are packed back to back; strings carry a presence byte and their terminator */
+static void input_bytes(SnapshotBuffer *b, const void *data, size_t len) {
+    if (snapshot_reserve(b, b->length + len)) {
+        memcpy(b->data + b->length, data, len);
+        b->length += len;
+    }
+}
+
+static void input_string(SnapshotBuffer *b, const char *s) {
+    unsigned char given = s != NULL;
+    input_bytes(b, &given, 1);
+    if (s) {
+        input_bytes(b, s, strlen(s) + 1);
+    }
+}
+
+/*
+ * Everything the parse of p would read, in a canonical form. Its hash is
+ * the snapshot key and the snapshot keeps a copy, compared byte for byte
+ * on load, so a colliding hash cannot load another command line's values.
+ */
+static void snapshot_inputs(const Parser *p, SnapshotBuffer *b) {
+    const OptionSpec *spec = p->spec;
+    
+    size_t layout[] = {sizeof(SnapshotValue), sizeof(void*), sizeof(size_t), spec->flags,
+                       (size_t)spec->option_count, (size_t)p->count};
+    input_bytes(b, layout, sizeof(layout));
+    for (int i = 0; i < spec->option_count; i++) {
+        const Option *opt = &spec->options[i];
+        int fields[] = {opt->short_name, opt->type, opt->required,
+                        opt->type == OPT_COUNT ? *(int*)option_target(p, opt) : 0};
+        input_bytes(b, fields, sizeof(fields));
+        input_string(b, opt->long_name);
+        input_string(b, opt->env);
+    }
+    for (int i = 0; i < p->count; i++) {
+        input_string(b, p->argv[i]);
+    }
+    
+    /* The config file by identity rather than contents: reading it is what a hit saves */
+    input_string(b, p->config_path);
+    input_string(b, p->config_section);
+    struct stat st;
+    if (p->config_path && stat(p->config_path, &st) == 0) {
+#ifdef __APPLE__
+        struct timespec mtime = st.st_mtimespec;
+#else
+        struct timespec mtime = st.st_mtim;
+#endif
+        int64_t id[] = {(int64_t)st.st_dev, (int64_t)st.st_ino, (int64_t)st.st_size,
+                        (int64_t)mtime.tv_sec, (int64_t)mtime.tv_nsec};
+        input_bytes(b, id, sizeof(id));
+    }
+    input_string(b, p->env_prefix);
+    if (p->env && (p->env_prefix || spec->env_slots)) {
+        for (char **e = p->env; *e; e++) {
+            input_string(b, *e);
+        }
+    }
+}
+
+static SnapshotValue snapshot_value(SnapshotBuffer *b, const Parser *p, int i) {
+    const Option *opt = &p->spec->options[i];
+    const void *target = option_target(p, opt);
+    SnapshotValue v = {p->counts[i], (uint32_t)opt->type, 0, 0};
+    
+    if (v.count == 0) {
+        return v;
+    }
+    switch (opt->type) {
+        case OPT_FLAG:
+        case OPT_INT:
+        case OPT_COUNT:
+            v.a = (uint64_t)(int64_t)*(const int*)target;
+            break;
+        case OPT_INT64:
+        case OPT_DURATION:
+            v.a = (uint64_t)*(const int64_t*)target;
+            break;
+        case OPT_UINT64:
+            v.a = *(const uint64_t*)target;
+            break;
+        case OPT_SIZE:
+            v.a = *(const size_t*)target;
+            break;
+        case OPT_DOUBLE:
+            memcpy(&v.a, target, sizeof(double));
+            break;
+        case OPT_STRING: {
+            const char *s = *(const char* const*)target;
+            v.b = strlen(s);
+            v.a = snapshot_put_string(b, s, v.b);
+            break;
+        }
+        case OPT_STRING_VIEW: {
+            const StringView *view = target;
+            v.b = view->length;
+            v.a = snapshot_put_string(b, view->data, view->length);
+            break;
+        }
+        case OPT_INT_LIST: {
+            const IntList *list = target;
+            v.b = list->count;
+            v.a = snapshot_put(b, list->items, sizeof(int) * list->count);
+            break;
+        }
+        case OPT_DOUBLE_LIST: {
+            const DoubleList *list = target;
+            v.b = list->count;
+            v.a = snapshot_put(b, list->items, sizeof(double) * list->count);
+            break;
+        }
+        case OPT_STRING_LIST: {
+            const StringList *list = target;
+            v.b = list->count;
+            v.a = snapshot_put(b, NULL, sizeof(uint64_t) * list->count);
+            for (size_t k = 0; k < list->count && !b->failed; k++) {
+                uint64_t offset = snapshot_put_string(b, list->items[k], strlen(list->items[k]));
+                memcpy(b->data + v.a + sizeof(uint64_t) * k, &offset, sizeof(offset));
+            }
+            break;
+        }
+    }
+    return v;
+}
+
+/* Write the snapshot of p's successful parse; the cache is best effort */
+static void save_snapshot(const Parser *p, const char *path, uint64_t key, const SnapshotBuffer *inputs) {
+    const ParseResult *result = p->result;
+    int option_count = p->spec->option_count;
+    SnapshotBuffer b = {NULL, 0, 0, 0};
+    
+    snapshot_put(&b, NULL, sizeof(SnapshotHeader));
+    uint64_t values = snapshot_put(&b, NULL, sizeof(SnapshotValue) * (size_t)option_count);
+    for (int i = 0; i < option_count && !b.failed; i++) {
+        SnapshotValue v = snapshot_value(&b, p, i);
+        if (!b.failed) {
+            memcpy(b.data + values + sizeof(SnapshotValue) * (size_t)i, &v, sizeof(v));
+        }
+    }
+    
+    /* Positionals are argv tokens in argv order */
+    uint64_t args = snapshot_put(&b, NULL, sizeof(uint64_t) * (size_t)result->arg_count);
+    for (int i = 0, k = 1; i < result->arg_count && !b.failed; i++, k++) {
+        while (p->argv[k] != result->args[i]) {
+            k++;
+        }
+        uint64_t index = (uint64_t)k;
+        memcpy(b.data + args + sizeof(uint64_t) * (size_t)i, &index, sizeof(index));
+    }
+    uint64_t input_offset = snapshot_put(&b, inputs->data, inputs->length);
+    if (b.failed) {
+        mem_free(NULL, b.data);
+        return;
+    }
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.key = key;
+    header.size = b.length;
+    header.option_count = (uint32_t)option_count;
+    header.arg_count = (uint32_t)result->arg_count;
+    header.args = args;
+    header.inputs = input_offset;
+    header.inputs_size = inputs->length;
+    memcpy(b.data, &header, sizeof(header));
+    
+    /* Written aside and renamed over the old one, so readers see either */
+    size_t path_len = strlen(path);
+    char *temp = mem_alloc(NULL, path_len + 8);
+    if (temp) {
+        memcpy(temp, path, path_len);
+        memcpy(temp + path_len, ".XXXXXX", 8);
+        int fd = mkstemp(temp);
+        if (fd >= 0) {
+            size_t done = 0;
+            while (done < b.length) {
+                ssize_t n = write(fd, b.data + done, b.length - done);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    break;
+                }
+                done += (size_t)n;
+            }
+            if (close(fd) != 0 || done < b.length || rename(temp, path) != 0) {
+                unlink(temp);
+            }
+        }
+        mem_free(NULL, temp);
+    }
+    mem_free(NULL, b.data);
+}
+
+/* A string of len bytes and its terminator at offset, inside size */
+static int snapshot_string_ok(const char *base, size_t size, uint64_t offset, uint64_t len) {
+    return offset <= size && len < size - offset && base[offset + len] == '\0';
+}
+
+static int snapshot_items_ok(size_t size, uint64_t offset, uint64_t count, size_t item_size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / item_size;
+}
+
+/* Everything a snapshot points at lies inside it, and it was made from the same inputs */
+static int snapshot_valid(const char *base, size_t size, const OptionSpec *spec, uint64_t key, int argc,
+                          const SnapshotBuffer *inputs) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, base, sizeof(header));
+    size_t values_size = sizeof(SnapshotValue) * (size_t)spec->option_count;
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.key != key ||
+        header.size != size || header.option_count != (uint32_t)spec->option_count ||
+        values_size > size - sizeof(header) ||
+        !snapshot_items_ok(size, header.args, header.arg_count, sizeof(uint64_t)) ||
+        header.inputs_size != inputs->length || !snapshot_items_ok(size, header.inputs, header.inputs_size, 1) ||
+        memcmp(base + header.inputs, inputs->data, inputs->length) != 0) {
+        return 0;
+    }
+    
+    const SnapshotValue *values = (const SnapshotValue*)(base + sizeof(header));
+    for (int i = 0; i < spec->option_count; i++) {
+        SnapshotValue v = values[i];
+        if (v.count == 0) {
+            continue;
+        }
+        if (v.type != (uint32_t)spec->options[i].type) {
+            return 0;
+        }
+        int ok = 1;
+        switch (spec->options[i].type) {
+            case OPT_STRING:
+            case OPT_STRING_VIEW:
+                ok = snapshot_string_ok(base, size, v.a, v.b);
+                break;
+            case OPT_INT_LIST:
+                ok = snapshot_items_ok(size, v.a, v.b, sizeof(int));
+                break;
+            case OPT_DOUBLE_LIST:
+                ok = snapshot_items_ok(size, v.a, v.b, sizeof(double));
+                break;
+            case OPT_STRING_LIST:
+                ok = snapshot_items_ok(size, v.a, v.b, sizeof(uint64_t));
+                for (uint64_t k = 0; ok && k < v.b; k++) {
+                    uint64_t offset;
+                    memcpy(&offset, base + v.a + sizeof(uint64_t) * k, sizeof(offset));
+                    ok = offset <= size && memchr(base + offset, '\0', size - offset) != NULL;
+                }
+                break;
+            default:
+                break;
+        }
+        if (!ok) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < header.arg_count; i++) {
+        uint64_t index;
+        memcpy(&index, base + header.args + sizeof(uint64_t) * i, sizeof(index));
+        if (index < 1 || index >= (uint64_t)argc) {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-/* Internal helper functions */
-static Option* find_long_option(Option *options, int count, const char *name) {
-    for (int i = 0; i < count; i++) {
-        if (options[i].long_name && strcmp(options[i].long_name, name) == 0) {
-            return &options[i];
+/* Offsets stored as uint64_t become pointers, in place and front to back */
+static void *patch_offsets(char *base, uint64_t offset, uint64_t count, char *const *argv) {
+    char **pointers = (char**)(base + offset);
+    for (uint64_t k = 0; k < count; k++) {
+        uint64_t stored;
+        memcpy(&stored, base + offset + sizeof(uint64_t) * k, sizeof(stored));
+        pointers[k] = argv ? argv[stored] : base + stored;
+    }
+    return pointers;
+}
+
+/* Load the snapshot at path into p's targets; 1 if there is no usable one */
+static int load_snapshot(Parser *p, const char *path, uint64_t key, const SnapshotBuffer *inputs) {
+    const OptionSpec *spec = p->spec;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        close(fd);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    char *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return 1;
+    }
+    if (!snapshot_valid(base, size, spec, key, p->count, inputs)) {
+        munmap(base, size);
+        return 1;
+    }
+    
+    memset(p->result, 0, sizeof(ParseResult));
+    memset(p->error, 0, sizeof(CliError));
+    p->error->index = -1;
+    p->result->allocator = p->allocator;
+    if (own_resource(p, base, size) != 0) {
+        munmap(base, size);
+        return -1;
+    }
+    
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    const SnapshotValue *values = (const SnapshotValue*)(base + sizeof(header));
+    for (int i = 0; i < spec->option_count; i++) {
+        SnapshotValue v = values[i];
+        const Option *opt = &spec->options[i];
+        void *target = option_target(p, opt);
+        p->counts[i] = v.count;
+        if (v.count == 0) {
+            continue;
+        }
+        switch (opt->type) {
+            case OPT_FLAG:
+            case OPT_INT:
+            case OPT_COUNT:
+                *(int*)target = (int)(int64_t)v.a;
+                break;
+            case OPT_INT64:
+            case OPT_DURATION:
+                *(int64_t*)target = (int64_t)v.a;
+                break;
+            case OPT_UINT64:
+                *(uint64_t*)target = v.a;
+                break;
+            case OPT_SIZE:
+                *(size_t*)target = (size_t)v.a;
+                break;
+            case OPT_DOUBLE:
+                memcpy(target, &v.a, sizeof(double));
+                break;
+            case OPT_STRING:
+                *(const char**)target = base + v.a;
+                break;
+            case OPT_STRING_VIEW:
+                ((StringView*)target)->data = base + v.a;
+                ((StringView*)target)->length = (size_t)v.b;
+                break;
+            case OPT_INT_LIST:
+                ((IntList*)target)->items = (int*)(base + v.a);
+                ((IntList*)target)->count = (size_t)v.b;
+                break;
+            case OPT_DOUBLE_LIST:
+                ((DoubleList*)target)->items = (double*)(base + v.a);
+                ((DoubleList*)target)->count = (size_t)v.b;
+                break;
+            case OPT_STRING_LIST:
+                ((StringList*)target)->items = patch_offsets(base, v.a, v.b, NULL);
+                ((StringList*)target)->count = (size_t)v.b;
+                break;
         }
     }
-    return NULL;
+    if (header.arg_count > 0) {
+        p->result->args = patch_offsets(base, header.args, header.arg_count, p->argv);
+        p->result->arg_count = (int)header.arg_count;
+        p->result->args_borrowed = 1;
+    }
+    return 0;
 }
 
-static Option* find_short_option(Option *options, int count, char name) {
-    for (int i = 0; i < count; i++) {
-        if (options[i].short_name == name) {
-            return &options[i];
+int cli_parse_cached(ParseContext *ctx, const OptionSpec *spec, int argc, char *argv[], const char *cache_path) {
+    if (!ctx || !spec || !argv || argc < 1 || !cache_path || ctx->lazy || ctx->on_positional ||
+        (spec->flags & (CLI_PERMUTE | CLI_RESPONSE_FILES))) {
+        return cli_parse_ctx(ctx, spec, argc, argv);
+    }
+    for (int i = 0; i < argc; i++) {
+        if (!argv[i]) {
+            return cli_parse_ctx(ctx, spec, argc, argv);
         }
     }
-    return NULL;
+    
+    /* Counts are part of the snapshot, so they are kept even if ctx does not want them */
+    unsigned *counts = ctx->counts;
+    if (!counts) {
+        counts = mem_alloc(NULL, sizeof(unsigned) * ((size_t)spec->option_count + 1));
+        if (!counts) {
+            return cli_parse_ctx(ctx, spec, argc, argv);
+        }
+    }
+    Parser parser = context_parser(ctx, spec);
+    parser.argv = argv;
+    parser.count = argc;
+    parser.counts = counts;
+    
+    SnapshotBuffer inputs = {NULL, 0, 0, 0};
+    snapshot_inputs(&parser, &inputs);
+    uint64_t key = hash_bytes(14695981039346656037ULL, inputs.data, inputs.length);
+    int ret = inputs.failed ? 1 : load_snapshot(&parser, cache_path, key, &inputs);
+    if (ret > 0) {
+        ret = parse_tokens(&parser);
+        if (ret == 0 && !inputs.failed) {
+            save_snapshot(&parser, cache_path, key, &inputs);
+        }
+    }
+    mem_free(NULL, inputs.data);
+    if (counts != ctx->counts) {
+        mem_free(NULL, counts);
+    }
+    return trace_parse(ret);
 }
 
-static int set_value(Option *opt, const char *value, ParseResult *result) {
-    switch (opt->type) {
-        case OPT_FLAG:
-            *(int*)opt->value = 1;
-            return 0;
-            
-        case OPT_INT: {
-            if (!value) {
-                result->error = "Integer option requires a value";
-                return -1;
-            }
-            char *end;
-            errno = 0;
-            long val = strtol(value, &end, 10);
-            if (errno == ERANGE || val > INT_MAX || val < INT_MIN) {
-                result->error = "Integer value out of range";
-                return -1;
-            }
-            if (*end != '\0') {
-                result->error = "Invalid integer value";
-                return -1;
-            }
-            *(int*)opt->value = (int)val;
-            return 0;
+/*
+ * Batch parsing. Workers claim chunks of items from a shared counter and
+ * parse each one into memory from their own arena, so the only shared
+ * writes are the counter and the items themselves.
+ */
+#define BATCH_CHUNK 64
+
+typedef struct {
+    const OptionSpec *spec;
+    const int *argcs;
+    char **const *argvs;
+    BatchItem *items;
+    int count;
+    int next;               /* first unclaimed item, guarded by lock */
+    pthread_mutex_t lock;
+} BatchJob;
+
+typedef struct {
+    BatchJob *job;
+    struct CliArena *arena;
+    struct CliResource *resources;
+    int failed;
+} BatchWorker;
+
+static void parse_batch_item(BatchWorker *w, int i) {
+    const OptionSpec *spec = w->job->spec;
+    BatchItem *item = &w->job->items[i];
+    ParseResult result;
+    
+    item->values = arena_alloc(&w->arena, sizeof(OptionValue) * (size_t)spec->option_count);
+    if (!item->values) {
+        memset(&item->error, 0, sizeof(CliError));
+        item->error.code = CLI_ERR_NO_MEMORY;
+        item->error.message = "Memory allocation failed";
+        item->error.index = -1;
+        item->status = -1;
+        w->failed++;
+        return;
+    }
+    memset(item->values, 0, sizeof(OptionValue) * (size_t)spec->option_count);
+    
+    Parser parser = {0};
+    parser.spec = spec;
+    parser.result = &result;
+    parser.error = &item->error;
+    parser.argv = w->job->argvs[i];
+    parser.count = w->job->argcs[i];
+    parser.index = -1;
+    parser.values = item->values;
+    parser.arena = &w->arena;
+    parser.env = environ;
+    item->status = parse_tokens(&parser);
+    item->args = result.args;
+    item->arg_count = result.arg_count;
+    if (item->status != 0) {
+        w->failed++;
+    }
+    
+    /* Response file mappings stay alive until cli_batch_free() */
+    while (result.resources) {
+        struct CliResource *res = result.resources;
+        result.resources = res->next;
+        res->next = w->resources;
+        w->resources = res;
+    }
+}
+
+static void *batch_worker(void *arg) {
+    BatchWorker *w = arg;
+    BatchJob *job = w->job;
+    
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int first = job->next;
+        if (first < job->count) {
+            job->next = job->count - first > BATCH_CHUNK ? first + BATCH_CHUNK : job->count;
         }
+        int last = job->next;
+        pthread_mutex_unlock(&job->lock);
         
-        case OPT_DOUBLE: {
-            if (!value) {
-                result->error = "Double option requires a value";
-                return -1;
-            }
-            char *end;
-            errno = 0;
-            double val = strtod(value, &end);
-            if (errno == ERANGE) {
-                result->error = "Double value out of range";
-                return -1;
-            }
-            if (*end != '\0') {
-                result->error = "Invalid double value";
-                return -1;
-            }
-            *(double*)opt->value = val;
-            return 0;
+        if (first >= last) {
+            return NULL;
+        }
+        for (int i = first; i < last; i++) {
+            parse_batch_item(w, i);
         }
-        
-        case OPT_STRING:
-            if (!value) {
-                result->error = "String option requires a value";
-                return -1;
-            }
-            *(const char**)opt->value = value;
-            return 0;
-            
-        default:
-            result->error = "Unknown option type";
-            return -1;
     }
 }
 
-static int add_positional(ParseResult *result, const char *arg) {
-    char **new_args = realloc(result->args, sizeof(char*) * (result->arg_count + 1));
-    if (!new_args) {
-        result->error = "Memory allocation failed";
+int cli_parse_batch(const OptionSpec *spec, int count, const int argcs[], char **const argvs[],
+                    int threads, BatchResult *batch) {
+    if (!batch) {
         return -1;
     }
-    result->args = new_args;
-    result->args[result->arg_count] = (char*)arg;
-    result->arg_count++;
-    return 0;
-}
-
-int cli_parse(int argc, char *argv[], Option *options, int option_count, ParseResult *result) {
-    if (!argv || !options || !result || argc < 0 || option_count < 0) {
-        if (result) result->error = "Invalid arguments";
+    memset(batch, 0, sizeof(BatchResult));
+    if (!spec || count < 0 || (count > 0 && (!argcs || !argvs))) {
         return -1;
     }
     
-    /* Initialize result */
-    memset(result, 0, sizeof(ParseResult));
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    int chunks = (count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    if (threads > chunks) {
+        threads = chunks > 0 ? chunks : 1;
+    }
     
-    for (int i = 1; i < argc; i++) {
-        char *arg = argv[i];
-        
-        if (!arg) {
-            result->error = "NULL argument encountered";
-            return -1;
+    BatchItem *items = mem_calloc(count > 0 ? (size_t)count : 1, sizeof(BatchItem));
+    BatchWorker *workers = mem_calloc((size_t)threads, sizeof(BatchWorker));
+    pthread_t *tids = mem_alloc(NULL, sizeof(pthread_t) * (size_t)threads);
+    if (!items || !workers || !tids) {
+        mem_free(NULL, items);
+        mem_free(NULL, workers);
+        mem_free(NULL, tids);
+        return -1;
+    }
+    
+    BatchJob job;
+    job.spec = spec;
+    job.argcs = argcs;
+    job.argvs = argvs;
+    job.items = items;
+    job.count = count;
+    job.next = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    
+    /* The calling thread is worker 0; if a thread fails to start the rest pick up its share */
+    int started = 1;
+    for (int t = 0; t < threads; t++) {
+        workers[t].job = &job;
+    }
+    while (started < threads && pthread_create(&tids[started], NULL, batch_worker, &workers[started]) == 0) {
+        started++;
+    }
+    batch_worker(&workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    
+    batch->items = items;
+    batch->count = count;
+    for (int t = 0; t < started; t++) {
+        BatchWorker *w = &workers[t];
+        batch->failed += w->failed;
+        while (w->arena) {
+            struct CliArena *block = w->arena;
+            w->arena = block->next;
+            block->next = batch->arenas;
+            batch->arenas = block;
         }
-        
-        /* Handle -- (end of options) */
-        if (strcmp(arg, "--") == 0) {
-            for (int j = i + 1; j < argc; j++) {
-                if (add_positional(result, argv[j]) != 0) {
-                    return -1;
-                }
-            }
+        while (w->resources) {
+            struct CliResource *res = w->resources;
+            w->resources = res->next;
+            res->next = batch->resources;
+            batch->resources = res;
+        }
+    }
+    mem_free(NULL, workers);
+    mem_free(NULL, tids);
+    return 0;
+}
+
+void cli_batch_free(BatchResult *batch) {
+    if (!batch) {
+        return;
+    }
+    mem_free(NULL, batch->items);
+    arena_free(batch->arenas);
+    release_resources(&batch->resources, NULL);
+    memset(batch, 0, sizeof(BatchResult));
+}
+
+/*
+ * Usage text. The option list depends only on the option table and the
+ * terminal width, so a spec renders it once and keeps it; printing is a
+ * single writev of the header pieces and the rendered list.
+ */
+#define USAGE_MIN_WIDTH 40
+#define USAGE_MAX_COLUMN 32     /* help text starts here at the latest */
+#define USAGE_MIN_HELP 20       /* narrowest column of help text */
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} UsageText;
+
+static void usage_append(UsageText *t, const char *s, size_t n) {
+    if (t->failed) {
+        return;
+    }
+    if (t->length + n > t->capacity) {
+        size_t capacity = t->capacity ? t->capacity : 1024;
+        while (capacity < t->length + n) {
+            capacity *= 2;
+        }
+        char *data = mem_realloc(NULL, t->data, capacity);
+        if (!data) {
+            t->failed = 1;
+            return;
+        }
+        t->data = data;
+        t->capacity = capacity;
+    }
+    memcpy(t->data + t->length, s, n);
+    t->length += n;
+}
+
+static void usage_puts(UsageText *t, const char *s) {
+    usage_append(t, s, strlen(s));
+}
+
+static void usage_pad(UsageText *t, size_t n) {
+    static const char spaces[] = "                                ";
+    while (n > 0) {
+        size_t chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        usage_append(t, spaces, chunk);
+        n -= chunk;
+    }
+}
+
+/* Columns of the terminal on stdout, else $COLUMNS, else 80 */
+static int usage_width(void) {
+    int width = 0;
+#ifdef TIOCGWINSZ
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+        width = ws.ws_col;
+    }
+#endif
+    if (width <= 0) {
+        const char *columns = getenv("COLUMNS");
+        width = columns ? atoi(columns) : 0;
+    }
+    if (width <= 0) {
+        width = 80;
+    }
+    return width < USAGE_MIN_WIDTH ? USAGE_MIN_WIDTH : width;
+}
+
+static const char *type_hint(OptionType type) {
+    switch (type) {
+        case OPT_INT:
+        case OPT_INT64:
+        case OPT_UINT64:
+            return " <num>";
+        case OPT_SIZE:
+            return " <size>";
+        case OPT_DURATION:
+            return " <duration>";
+        case OPT_DOUBLE:
+            return " <float>";
+        case OPT_STRING:
+        case OPT_STRING_VIEW:
+            return " <string>";
+        case OPT_INT_LIST:
+            return " <num,...>";
+        case OPT_DOUBLE_LIST:
+            return " <float,...>";
+        case OPT_STRING_LIST:
+            return " <string>...";
+        case OPT_FLAG:
+        case OPT_COUNT:
             break;
+    }
+    return "";
+}
+
+/* "  -v, --verbose <num>"; the type hint follows the long name only */
+static size_t usage_left(UsageText *t, const Option *opt) {
+    size_t start = t->length;
+    usage_puts(t, "  ");
+    if (opt->short_name) {
+        char name[2] = {'-', opt->short_name};
+        usage_append(t, name, 2);
+        if (opt->long_name) {
+            usage_puts(t, ", ");
         }
-        
-        /* Long option --name or --name=value */
-        if (arg[0] == '-' && arg[1] == '-' && arg[2] != '\0') {
-            char *name = arg + 2;
-            char *value = strchr(name, '=');
-            
-            if (value) {
-                *value = '\0';  /* Split at = */
-                value++;
-            }
-            
-            Option *opt = find_long_option(options, option_count, name);
-            if (!opt) {
-                result->error = "Unknown option";
-                return -1;
-            }
-            
-            if (opt->type == OPT_FLAG) {
-                if (value) {
-                    result->error = "Flag option does not accept a value";
-                    return -1;
-                }
-                *(int*)opt->value = 1;
-            } else {
-                if (!value) {
-                    if (i + 1 >= argc) {
-                        result->error = "Option requires a value";
-                        return -1;
-                    }
-                    value = argv[++i];
-                }
-                if (set_value(opt, value, result) != 0) {
-                    return -1;
-                }
-            }
+    } else {
+        usage_puts(t, "    ");
+    }
+    if (opt->long_name) {
+        usage_puts(t, "--");
+        usage_puts(t, opt->long_name);
+        usage_puts(t, type_hint(opt->type));
+    }
+    return t->length - start;
+}
+
+static size_t left_width(const Option *opt) {
+    if (!opt->long_name) {
+        return opt->short_name ? 4 : 6;
+    }
+    return 6 + 2 + strlen(opt->long_name) + strlen(type_hint(opt->type));
+}
+
+/* Append words, breaking lines at width columns and indenting them to column */
+static void usage_wrap(UsageText *t, const char *text, size_t column, size_t width, size_t *line) {
+    const char *s = text;
+    while (*s) {
+        while (*s == ' ') {
+            s++;
         }
-        /* Short option -x */
-        else if (arg[0] == '-' && arg[1] != '\0' && arg[1] != '-') {
-            char name = arg[1];
-            
-            Option *opt = find_short_option(options, option_count, name);
-            if (!opt) {
-                result->error = "Unknown option";
-                return -1;
-            }
-            
-            if (opt->type == OPT_FLAG) {
-                *(int*)opt->value = 1;
-            } else {
-                if (i + 1 >= argc) {
-                    result->error = "Option requires a value";
-                    return -1;
-                }
-                if (set_value(opt, argv[++i], result) != 0) {
-                    return -1;
-                }
-            }
+        size_t word = strcspn(s, " ");
+        if (word == 0) {
+            break;
         }
-        /* Positional argument */
-        else {
-            if (add_positional(result, arg) != 0) {
-                return -1;
-            }
+        if (*line > 0 && *line + 1 + word > width) {
+            usage_append(t, "\n", 1);
+            usage_pad(t, column);
+            *line = 0;
+        } else if (*line > 0) {
+            usage_append(t, " ", 1);
+            (*line)++;
         }
+        usage_append(t, s, word);
+        *line += word;
+        s += word;
+    }
+}
+
+/* Options block, help aligned to one column and wrapped to width */
+static int render_options(UsageText *t, const Option *options, int option_count, int width) {
+    if (option_count <= 0) {
+        return 0;
     }
     
-    /* Check required options (but skip if help was requested) */
-    int help_requested = 0;
+    size_t column = 0;
     for (int i = 0; i < option_count; i++) {
-        if (options[i].type == OPT_FLAG && 
-            ((options[i].long_name && strcmp(options[i].long_name, "help") == 0) ||
-             options[i].short_name == 'h')) {
-            if (*(int*)options[i].value != 0) {
-                help_requested = 1;
-                break;
-            }
+        size_t w = left_width(&options[i]) + 2;
+        if (w <= USAGE_MAX_COLUMN && w > column) {
+            column = w;
         }
     }
+    if (column == 0) {
+        column = USAGE_MAX_COLUMN;
+    }
+    size_t help_width = (size_t)width > column + USAGE_MIN_HELP ? (size_t)width - column : USAGE_MIN_HELP;
     
-    if (!help_requested) {
-        for (int i = 0; i < option_count; i++) {
+    usage_puts(t, "\nOptions:\n");
+    for (int i = 0; i < option_count; i++) {
+        size_t left = usage_left(t, &options[i]);
+        if (options[i].help || options[i].required) {
+            if (left + 2 > column) {
+                usage_append(t, "\n", 1);
+                usage_pad(t, column);
+            } else {
+                usage_pad(t, column - left);
+            }
+            size_t line = 0;
+            if (options[i].help) {
+                usage_wrap(t, options[i].help, column, help_width, &line);
+            }
             if (options[i].required) {
-                int is_set = 0;
-                
-                switch (options[i].type) {
-                    case OPT_FLAG:
-                        is_set = *(int*)options[i].value != 0;
-                        break;
-                    case OPT_STRING:
-                        is_set = *(const char**)options[i].value != NULL;
-                        break;
-                    case OPT_INT:
-                    case OPT_DOUBLE:
-                        /* Assume numeric options are set if we got here */
-                        is_set = 1;
-                        break;
-                }
-                
-                if (!is_set) {
-                    result->error = "Required option missing";
-                    return -1;
-                }
+                usage_wrap(t, "(required)", column, help_width, &line);
+            }
+        }
+        usage_append(t, "\n", 1);
+    }
+    return t->failed ? -1 : 0;
+}
+
+/* writev until everything is out; errors other than EINTR drop the rest */
+static void write_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            return;
+        }
+        size_t done = (size_t)n;
+        while (count > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + done;
+            iov->iov_len -= done;
         }
     }
+}
+
+#define IOV_STRING(iov, n, s) \
+    ((iov)[(n)].iov_base = (void*)(s), (iov)[(n)].iov_len = strlen(s), (n)++)
+
+/* command, if any, follows the program name in the synopsis */
+static void write_usage(const char *program_name, const char *command, const char *description,
+                        const char *options_text, size_t length) {
+    struct iovec iov[9];
+    int n = 0;
+    IOV_STRING(iov, n, "Usage: ");
+    IOV_STRING(iov, n, program_name ? program_name : "program");
+    if (command) {
+        IOV_STRING(iov, n, " ");
+        IOV_STRING(iov, n, command);
+    }
+    IOV_STRING(iov, n, " [options] [arguments]\n");
+    if (description) {
+        IOV_STRING(iov, n, "\n");
+        IOV_STRING(iov, n, description);
+        IOV_STRING(iov, n, "\n");
+    }
+    iov[n].iov_base = (void*)options_text;
+    iov[n].iov_len = options_text ? length : 0;
+    n++;
     
-    return 0;
+    /* Anything the program printed so far comes first */
+    fflush(stdout);
+    write_all(STDOUT_FILENO, iov, n);
 }
 
 void cli_usage(const char *program_name, Option *options, int option_count, const char *description) {
-    printf("Usage: %s [options] [arguments]\n", program_name ? program_name : "program");
+    STAT_CLOCK(usage_started);
+    UsageText text = {0};
+    render_options(&text, options, option_count, usage_width());
+    write_usage(program_name, NULL, description, text.failed ? NULL : text.data, text.length);
+    mem_free(NULL, text.data);
+    STAT_ELAPSED(usage_ns, usage_started);
+    trace_parse(0);
+}
+
+static void spec_usage(const OptionSpec *spec, const char *program_name, const char *command,
+                       const char *description) {
+    STAT_CLOCK(usage_started);
+    /* The cached text is not part of the spec's logical state */
+    OptionSpec *cache = (OptionSpec*)spec;
+    int width = usage_width();
     
-    if (description) {
-        printf("\n%s\n", description);
+    pthread_mutex_lock(&cache->usage_lock);
+    if (!cache->usage || cache->usage_width != width) {
+        UsageText text = {0};
+        mem_free(NULL, cache->usage);
+        cache->usage = NULL;
+        if (render_options(&text, spec->options, spec->option_count, width) == 0) {
+            cache->usage = text.data;
+            cache->usage_length = text.length;
+            cache->usage_width = width;
+        } else {
+            mem_free(NULL, text.data);
+        }
+    }
+    write_usage(program_name, command, description, cache->usage, cache->usage_length);
+    pthread_mutex_unlock(&cache->usage_lock);
+    STAT_ELAPSED(usage_ns, usage_started);
+    trace_parse(0);
+}
+
+void cli_spec_usage(const OptionSpec *spec, const char *program_name, const char *description) {
+    if (spec) {
+        spec_usage(spec, program_name, NULL, description);
+    }
+}
+
+void cli_usage_hint(const OptionSpec *spec, const char *program_name, const char *message) {
+    const char *program = program_name ? program_name : "program";
+    const Option *help = spec && spec->help_index >= 0 ? &spec->options[spec->help_index] : NULL;
+    char short_help[3] = {'-', help ? help->short_name : 0, '\0'};
+    struct iovec iov[8];
+    int n = 0;
+    
+    if (message) {
+        IOV_STRING(iov, n, "Error: ");
+        IOV_STRING(iov, n, message);
+        IOV_STRING(iov, n, "\n");
+    }
+    if (help) {
+        IOV_STRING(iov, n, "Try '");
+        IOV_STRING(iov, n, program);
+        IOV_STRING(iov, n, help->long_name ? " --" : " ");
+        IOV_STRING(iov, n, help->long_name ? help->long_name : short_help);
+        IOV_STRING(iov, n, "' for more information.\n");
+    } else {
+        IOV_STRING(iov, n, "Usage: ");
+        IOV_STRING(iov, n, program);
+        IOV_STRING(iov, n, " [options] [arguments]\n");
+    }
+    fflush(stderr);
+    write_all(STDERR_FILENO, iov, n);
+}
+
+/* The command list of a set, aligned like the options */
+static int render_commands(UsageText *t, const Command *commands, int command_count, int width) {
+    size_t column = 0;
+    for (int i = 0; i < command_count; i++) {
+        size_t w = strlen(commands[i].name) + 4;
+        if (w <= USAGE_MAX_COLUMN && w > column) {
+            column = w;
+        }
+    }
+    if (column == 0) {
+        column = USAGE_MAX_COLUMN;
     }
+    size_t help_width = (size_t)width > column + USAGE_MIN_HELP ? (size_t)width - column : USAGE_MIN_HELP;
     
-    if (option_count > 0) {
-        printf("\nOptions:\n");
-        
-        for (int i = 0; i < option_count; i++) {
-            printf("  ");
-            
-            /* Short option */
-            if (options[i].short_name) {
-                printf("-%c", options[i].short_name);
-                if (options[i].long_name) {
-                    printf(", ");
-                }
+    usage_puts(t, "\nCommands:\n");
+    for (int i = 0; i < command_count; i++) {
+        size_t left = strlen(commands[i].name) + 2;
+        usage_puts(t, "  ");
+        usage_puts(t, commands[i].name);
+        if (commands[i].help) {
+            if (left + 2 > column) {
+                usage_append(t, "\n", 1);
+                usage_pad(t, column);
             } else {
-                printf("    ");
-            }
-            
-            /* Long option */
-            if (options[i].long_name) {
-                printf("--%s", options[i].long_name);
-                
-                /* Add type hint for non-flags */
-                switch (options[i].type) {
-                    case OPT_INT:
-                        printf(" <num>");
-                        break;
-                    case OPT_DOUBLE:
-                        printf(" <float>");
-                        break;
-                    case OPT_STRING:
-                        printf(" <string>");
-                        break;
-                    case OPT_FLAG:
-                        break;
-                }
-            }
-            
-            /* Required marker */
-            if (options[i].required) {
-                printf(" (required)");
-            }
-            
-            /* Help text */
-            if (options[i].help) {
-                printf("\n      %s", options[i].help);
+                usage_pad(t, column - left);
             }
-            
-            printf("\n");
+            size_t line = 0;
+            usage_wrap(t, commands[i].help, column, help_width, &line);
         }
+        usage_append(t, "\n", 1);
+    }
+    return t->failed ? -1 : 0;
+}
+
+void cli_commands_usage(const CommandSet *set, const char *program_name, const char *description) {
+    if (!set) {
+        return;
+    }
+    STAT_CLOCK(usage_started);
+    UsageText text = {0};
+    int width = usage_width();
+    render_options(&text, set->global->options, set->global->option_count, width);
+    render_commands(&text, set->commands, set->command_count, width);
+    write_usage(program_name, "<command>", description, text.failed ? NULL : text.data, text.length);
+    mem_free(NULL, text.data);
+    STAT_ELAPSED(usage_ns, usage_started);
+    trace_parse(0);
+}
+
+void cli_command_usage(const CommandSet *set, int command, const char *program_name) {
+    const OptionSpec *spec = cli_command_spec(set, command);
+    if (spec) {
+        spec_usage(spec, program_name, set->commands[command].name, set->commands[command].description);
     }
 }
 
 void cli_free(ParseResult *result) {
     if (result && result->args) {
-        free(result->args);
+        if (!result->args_borrowed) {
+            mem_free(result->allocator, result->args);
+        }
         result->args = NULL;
         result->arg_count = 0;
     }
+    if (result && result->arg_views) {
+        mem_free(result->allocator, result->arg_views);
+        result->arg_views = NULL;
+        result->arg_count = 0;
+    }
+    if (result) {
+        release_resources(&result->resources, result->allocator);
+    }
 }
\ No newline at end of file
@@ -7,7 +7,7 @@
  * 
  * Usage: Just use CONFIGURE() macro with your options
  * 
- * Version: 3.0.0 - SmartArgs Edition
+ * Version: 4.0.0 - SmartArgs Edition
  */
 
 #ifdef __cplusplus
@@ -15,6 +15,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -23,10 +24,50 @@ typedef enum {
     OPT_FLAG,    /* Boolean flag */
     OPT_INT,     /* Integer value */
     OPT_STRING,  /* String value */
-    OPT_DOUBLE   /* Double value */
+    OPT_DOUBLE,  /* Double value */
+    OPT_STRING_VIEW, /* String value as a StringView, never copied or written */
+    OPT_INT64,   /* int64_t value */
+    OPT_UINT64,  /* uint64_t value */
+    OPT_SIZE,    /* size_t byte count, accepts K/M/G/T/P/E suffixes */
+    OPT_DURATION, /* int64_t nanoseconds, accepts ns/us/ms/s/m/h/d units */
+    OPT_INT_LIST,    /* IntList, repeatable and comma-separated */
+    OPT_DOUBLE_LIST, /* DoubleList, repeatable and comma-separated */
+    OPT_STRING_LIST, /* StringList, one element per occurrence */
+    OPT_COUNT        /* int, one more per occurrence: -vvv adds 3 */
 } OptionType;
 
-/* Internal option definition */
+/* Non-owning view of a string that need not be NUL-terminated */
+typedef struct {
+    const char *data;
+    size_t length;
+} StringView;
+
+/*
+ * Values of the list types: one contiguous array owned by the ParseResult,
+ * valid until cli_free() or cli_ctx_free(). The first occurrence in argv,
+ * the environment or the config file replaces any earlier items, later
+ * ones in the same place append.
+ */
+typedef struct {
+    int *items;
+    size_t count;
+} IntList;
+
+typedef struct {
+    double *items;
+    size_t count;
+} DoubleList;
+
+typedef struct {
+    const char **items;
+    size_t count;
+} StringList;
+
+/*
+ * Internal option definition. Build it with the macros below, or with
+ * designated initializers: fields are added between major versions, and
+ * positional initializers would miss them.
+ */
 typedef struct {
     const char *long_name;
     char short_name;
@@ -34,20 +75,365 @@ typedef struct {
     void *value;
     const char *help;
     int required;
+    const char *env;    /* Environment variable read when argv lacks the option, or NULL */
 } Option;
 
+/*
+ * Allocator for everything a parse hands back: positionals, list items,
+ * expanded response files, config and response file contents (read rather
+ * than mapped) and the records tracking them. realloc(NULL) allocates and
+ * a NULL return fails the parse with CLI_ERR_NO_MEMORY.
+ */
+typedef struct {
+    void *(*alloc)(void *userdata, size_t size);
+    void *(*realloc)(void *userdata, void *ptr, size_t size);
+    void (*free)(void *userdata, void *ptr);
+    void *userdata;
+} CliAllocator;
+
 /* Parse result for internal use */
 typedef struct {
     char **args;
     int arg_count;
     const char *error;
+    int args_borrowed;  /* args points into argv (CLI_PERMUTE), nothing to free */
+    StringView *arg_views;  /* Positionals when parsing views (args is NULL) */
+    struct CliResource *resources;  /* Response file mappings etc., freed by cli_free() */
+    const CliAllocator *allocator;  /* Where args and resources came from, NULL for malloc */
 } ParseResult;
 
+/* Error codes reported through CliError */
+typedef enum {
+    CLI_OK = 0,
+    CLI_ERR_INVALID_ARGUMENTS,  /* Bad parameters or a NULL argv entry */
+    CLI_ERR_UNKNOWN_OPTION,     /* No such long or short option */
+    CLI_ERR_MISSING_VALUE,      /* Option requires a value */
+    CLI_ERR_UNEXPECTED_VALUE,   /* Flag given --flag=value */
+    CLI_ERR_INVALID_VALUE,      /* Value does not parse as the option type */
+    CLI_ERR_OUT_OF_RANGE,       /* Value does not fit the option type */
+    CLI_ERR_REQUIRED_MISSING,   /* Required option not given */
+    CLI_ERR_NO_MEMORY,          /* Allocation failed */
+    CLI_ERR_RESPONSE_FILE,      /* @file nesting too deep, or too many @files */
+    CLI_ERR_CONFIG_FILE,        /* Config file unreadable or malformed */
+    CLI_ERR_AMBIGUOUS_OPTION,   /* Abbreviation matches several long options */
+    CLI_ERR_UNKNOWN_COMMAND     /* No such subcommand */
+} CliErrorCode;
+
+#define CLI_MAX_SUGGESTIONS 3
+
+/* Structured error for the context API */
+typedef struct {
+    CliErrorCode code;
+    const char *message;        /* Same text as ParseResult.error */
+    int index;                  /* argv index of the offending token, -1 if none */
+    const char *option;         /* Long name of the option involved, if any */
+    char short_name;            /* Short name of the option involved, if any */
+    const char *source;         /* Config file or NAME=value environment entry the value
+                                   came from, NULL for argv */
+    int line;                   /* Line in the config file, 0 if none */
+    const char *suggestions[CLI_MAX_SUGGESTIONS];  /* Closest long names for an unknown or
+                                                      ambiguous option, best first, NULL-padded */
+} CliError;
+
+/*
+ * Streaming positional handler, called in argv order with every option
+ * before the positional already applied. Return nonzero to stop parsing.
+ */
+typedef int (*PositionalCallback)(StringView arg, void *userdata);
+
+/* Value of one option outside its variable; read the member matching its type */
+typedef union {
+    int i;                      /* OPT_FLAG, OPT_INT, OPT_COUNT */
+    int64_t i64;                /* OPT_INT64, OPT_DURATION */
+    uint64_t u64;               /* OPT_UINT64 */
+    size_t size;                /* OPT_SIZE */
+    double d;                   /* OPT_DOUBLE */
+    const char *s;              /* OPT_STRING */
+    StringView view;            /* OPT_STRING_VIEW */
+    IntList ints;               /* OPT_INT_LIST */
+    DoubleList doubles;         /* OPT_DOUBLE_LIST */
+    StringList strings;         /* OPT_STRING_LIST */
+} OptionValue;
+
+/*
+ * One option of a lazy parse (ParseContext.lazy). Parsing records the slice
+ * of the last value given and the cli_get_*() accessors convert it on first
+ * read. Flags and lists are applied while parsing, as they accumulate.
+ */
+typedef struct {
+    StringView raw;             /* Last value given */
+    OptionType type;            /* Of the option, copied so the table need not outlive the parse */
+    const char *long_name;      /* For errors reported when raw is converted */
+    int index;                  /* argv index of raw, -1 for config and environment */
+    const char *source;         /* Config file or environment entry of raw, NULL for argv */
+    int line;
+    int terminated;             /* raw is NUL-terminated (not parsed from views) */
+    int state;                  /* Internal: not given, raw or converted */
+    OptionValue value;          /* Valid once converted */
+} LazyValue;
+
+/*
+ * Caller-owned parse context. Parsing through a context never exits and
+ * never touches the args/arg_count globals, so separate threads can parse
+ * separate argument vectors (with separate Option tables) concurrently.
+ */
+typedef struct {
+    ParseResult result;         /* Positionals, freed by cli_ctx_free() */
+    CliError error;
+    
+    /* Optional inputs, set before parsing */
+    PositionalCallback on_positional;  /* Stream positionals, result.args stays empty */
+    void *userdata;
+    OptionValue *values;        /* One per option: store values here, not in Option.value */
+    LazyValue *lazy;            /* One per option: record raw values here instead, see cli_get_value() */
+    unsigned *counts;           /* One per option: times each was given, 0 if left at its default */
+    const char *config_path;    /* INI file applied before argv, ignored if missing */
+    const char *config_section; /* Its [section] applied after the top-level keys */
+    const char *env_prefix;     /* "APP_" reads --dry-run from APP_DRY_RUN */
+    const CliAllocator *allocator;  /* Memory for ctx->result, NULL for malloc; must outlive it */
+    char **environment;         /* NAME=value entries read instead of environ, NULL-terminated */
+} ParseContext;
+
+/* Parse behaviour flags for cli_compile_ex() */
+typedef enum {
+    CLI_PERMUTE = 1 << 0,        /* Permute argv in place so positionals form its tail */
+    CLI_RESPONSE_FILES = 1 << 1, /* Expand @file tokens (gcc style, nested up to 16 deep) */
+    CLI_PREFIX_MATCH = 1 << 2    /* Accept unambiguous abbreviations of long names: --verb */
+} ParseFlags;
+
+/* Compiled option table with hashed long-name lookup (opaque) */
+typedef struct OptionSpec OptionSpec;
+
+/*
+ * Parse statistics, collected per thread when the library is built with
+ * SMARTARGS_STATS (cmake -DSMARTARGS_STATS=ON) and always zero otherwise.
+ * Such builds print them as one JSON line on stderr after every parse and
+ * usage rendering once argv contained the hidden --smartargs-trace flag,
+ * or whenever SMARTARGS_TRACE is set to something other than 0.
+ */
+typedef struct {
+    unsigned long tokens;       /* argv tokens scanned */
+    unsigned long lookups;      /* hashed name lookups (long, env and config names) */
+    unsigned long probes;       /* hash slots visited by those lookups */
+    unsigned long max_probes;   /* most slots visited by a single lookup */
+    unsigned long allocations;  /* heap allocations by the library */
+    unsigned long bytes;        /* bytes requested by them */
+    uint64_t scan_ns;           /* token scan, conversions excluded */
+    uint64_t convert_ns;        /* numeric conversions */
+    uint64_t required_ns;       /* required option check */
+    uint64_t usage_ns;          /* usage rendering */
+} CliStats;
+
+void cli_stats_get(CliStats *stats);
+void cli_stats_reset(void);
+void cli_stats_dump(FILE *out);
+
 /* Internal functions - users don't need to call these directly */
 int cli_parse(int argc, char *argv[], Option *options, int option_count, ParseResult *result);
 void cli_usage(const char *program_name, Option *options, int option_count, const char *description);
 void cli_free(ParseResult *result);
 
+/*
+ * Compile an option table once and parse any number of argument vectors
+ * against it. The spec references the Option array, which must outlive it;
+ * which options are required is taken from the array when it is compiled.
+ */
+OptionSpec *cli_compile(Option *options, int option_count);
+OptionSpec *cli_compile_ex(Option *options, int option_count, unsigned flags);
+int cli_parse_spec(const OptionSpec *spec, int argc, char *argv[], ParseResult *result);
+void cli_spec_free(OptionSpec *spec);
+const Option *cli_spec_options(const OptionSpec *spec, int *option_count);
+
+/*
+ * Usage from a compiled table. The option list is rendered once per spec
+ * (again only if the terminal width changes), aligned and wrapped, and
+ * printed to stdout with a single write. cli_usage_hint() is the short
+ * error path: the message and one line pointing at --help, on stderr.
+ */
+void cli_spec_usage(const OptionSpec *spec, const char *program_name, const char *description);
+void cli_usage_hint(const OptionSpec *spec, const char *program_name, const char *message);
+
+/*
+ * Context API. cli_parse_ctx() returns 0 on success and -1 on error with
+ * ctx->error filled in, or 1 when ctx->on_positional stopped the parse
+ * (remaining arguments and required options are then not checked).
+ * cli_configure_ctx() compiles the table itself and returns 1 after
+ * printing usage when the help flag was given.
+ *
+ * Required options are checked against the set of options actually given
+ * from any source, so a required INT is missing even when its variable
+ * holds a default. With ctx->counts set, counts[i] is how many times
+ * option i was given: 0 means the value is still the default.
+ */
+int cli_parse_ctx(ParseContext *ctx, const OptionSpec *spec, int argc, char *argv[]);
+int cli_configure_ctx(ParseContext *ctx, int argc, char *argv[], Option *options, int option_count,
+                      const char *description);
+void cli_ctx_free(ParseContext *ctx);
+
+/*
+ * Snapshot cache for tools started over and over with the same inputs.
+ * cli_parse_cached() parses like cli_parse_ctx() and, on success, writes
+ * the resolved values and positionals to cache_path. A later call with
+ * the same argv, option table, config file (path, size and mtime) and
+ * environment maps that file and loads the values from it without parsing;
+ * those inputs are stored in the snapshot and compared in full, not only
+ * by hash.
+ * Strings and list items then point into the mapping, which the result
+ * owns; positionals still point at argv. A missing, stale or damaged
+ * snapshot is simply replaced. Parses with ctx->lazy or ctx->on_positional
+ * and tables compiled with CLI_PERMUTE or CLI_RESPONSE_FILES are never cached.
+ */
+int cli_parse_cached(ParseContext *ctx, const OptionSpec *spec, int argc, char *argv[],
+                     const char *cache_path);
+
+/*
+ * Bump arena for ParseContext.allocator, over a caller's buffer or, when
+ * buffer is NULL, one malloc'd block of size bytes. size is a hard budget:
+ * a parse needing more fails with CLI_ERR_NO_MEMORY and nothing is grown.
+ * free() only gives back the latest block. cli_arena_reset() releases
+ * everything in O(1); results parsed from the arena must not be used or
+ * passed to cli_free() afterwards. cli_arena_init() returns -1 if the
+ * block cannot be allocated.
+ */
+typedef struct {
+    CliAllocator allocator;     /* Set ctx.allocator = &arena.allocator */
+    char *base;
+    size_t size;
+    size_t used;
+    size_t peak;                /* Largest used since init */
+    void *owned;                /* Block allocated by cli_arena_init(), NULL for a caller's buffer */
+} CliBumpArena;
+
+int cli_arena_init(CliBumpArena *arena, void *buffer, size_t size);
+void cli_arena_reset(CliBumpArena *arena);
+void cli_arena_destroy(CliBumpArena *arena);
+
+/*
+ * Lazy conversion: with ctx->lazy set, a parse records only the winning
+ * token of each option and converts nothing; repeated options and options
+ * the program never reads cost no conversion. Each accessor converts on
+ * first use and returns 1 with the value, 0 if the option was not given
+ * (value untouched) or -1 with ctx->error filled in, carrying the argv
+ * index of the bad value as an eager parse would. option is the index in
+ * the option table; cli_get_int() also reads COUNT options and
+ * cli_get_int64() DURATION options. Values stay valid until cli_ctx_free().
+ */
+int cli_get_value(ParseContext *ctx, int option, OptionValue *value);
+int cli_get_flag(ParseContext *ctx, int option, int *value);
+int cli_get_int(ParseContext *ctx, int option, int *value);
+int cli_get_int64(ParseContext *ctx, int option, int64_t *value);
+int cli_get_uint64(ParseContext *ctx, int option, uint64_t *value);
+int cli_get_size(ParseContext *ctx, int option, size_t *value);
+int cli_get_double(ParseContext *ctx, int option, double *value);
+int cli_get_string(ParseContext *ctx, int option, const char **value);
+int cli_get_view(ParseContext *ctx, int option, StringView *value);
+
+/*
+ * Parse read-only tokens given as views, e.g. slices of an mmap'd job file.
+ * tokens[0] is the program name as with argv. Nothing is copied or written:
+ * positionals land in ctx->result.arg_views and string values need
+ * STRING_VIEW options.
+ */
+int cli_parse_views(ParseContext *ctx, const OptionSpec *spec, int count, const StringView tokens[]);
+
+/*
+ * Parse NUL-separated tokens read from fd until EOF, as in /proc/<pid>/cmdline
+ * or the output of find -print0; the last token needs no terminator. The
+ * stream holds argv[0] too when program_name is NULL. Input is read in 64KB
+ * chunks and parsed as it arrives. With ctx->on_positional set the chunk
+ * buffer is reused and only string values are copied, one copy per scalar
+ * option however often it repeats (a list grows by its items); otherwise
+ * positionals are collected in ctx->result.args. Error indexes
+ * count tokens from argv[0]. @files and CLI_PERMUTE do not apply to streams.
+ */
+int cli_parse_fd(ParseContext *ctx, const OptionSpec *spec, int fd, const char *program_name);
+
+/* One subcommand of a CommandSet, with its own option table */
+typedef struct {
+    const char *name;
+    const char *help;           /* One line for the command list, or NULL */
+    Option *options;
+    int option_count;
+    const char *description;    /* Shown by cli_command_usage(), or NULL */
+} Command;
+
+/* Global options plus named subcommands (opaque) */
+typedef struct CommandSet CommandSet;
+
+#define CLI_NO_COMMAND (-2)
+
+/*
+ * Subcommands, git style: tool [global options] <command> [options] [arguments].
+ * Compiling the set only indexes the command names; a command's own table
+ * is compiled the first time it is selected, so a parse never pays for the
+ * tables of the other commands. The Option and Command arrays must outlive
+ * the set.
+ *
+ * cli_parse_command() parses the global options up to the first positional,
+ * looks the command up by name and parses the rest against its table.
+ * It returns the command's index, CLI_NO_COMMAND when argv names none, or
+ * -1 on error (CLI_ERR_UNKNOWN_COMMAND comes with suggestions). Global
+ * options go to their variables; ctx->values, if set, is for the command's
+ * table. Error indexes are argv indexes in either part.
+ */
+CommandSet *cli_commands_compile(Option *global, int global_count, Command *commands, int command_count);
+void cli_commands_free(CommandSet *set);
+int cli_parse_command(ParseContext *ctx, const CommandSet *set, int argc, char *argv[]);
+const OptionSpec *cli_command_spec(const CommandSet *set, int command);
+void cli_commands_usage(const CommandSet *set, const char *program_name, const char *description);
+void cli_command_usage(const CommandSet *set, int command, const char *program_name);
+
+/* Outcome of one argument vector in a batch */
+typedef struct {
+    int status;                 /* 0, or -1 with error filled in */
+    CliError error;
+    char **args;                /* Positionals (pointers into the input argv) */
+    int arg_count;
+    OptionValue *values;        /* One per option of the spec, zeroed if not given */
+} BatchItem;
+
+/* Results of cli_parse_batch(), in input order, freed by cli_batch_free() */
+typedef struct {
+    BatchItem *items;
+    int count;
+    int failed;                 /* Number of items with status -1 */
+    struct CliArena *arenas;    /* Per-worker blocks backing args and values */
+    struct CliResource *resources;
+} BatchResult;
+
+/*
+ * Parse count argument vectors against one spec on a pool of threads
+ * (threads <= 0 uses one per online CPU). Option values go to each item's
+ * values instead of the variables in the Option table, so the table is
+ * only read. Environment fallbacks apply to every item as in cli_parse().
+ * Returns 0 once every vector was parsed, whatever their status, and -1 if
+ * the batch could not be run at all.
+ */
+int cli_parse_batch(const OptionSpec *spec, int count, const int argcs[], char **const argvs[],
+                    int threads, BatchResult *batch);
+void cli_batch_free(BatchResult *batch);
+
+/*
+ * Parse server (smartargs_server.c). Keeps a compiled spec resident and
+ * answers each request, an argc token followed by argc NUL-terminated
+ * tokens (argv[0] first), with one line of JSON:
+ *
+ *   {"status":0,"values":{"threads":8,"name":"x"},"args":["in"]}
+ *   {"status":-1,"error":{"code":5,"message":"Invalid integer value","index":2,"option":"threads"}}
+ *
+ * Values start from the Option variables as they are when serving starts;
+ * the variables themselves are never written. Requests are parsed without
+ * an environment, so replies do not depend on the server's. Compile the
+ * spec without CLI_RESPONSE_FILES unless clients may read files as the
+ * server. cli_serve_fd() answers requests from in_fd on out_fd until EOF
+ * and returns 0, or -1 on an I/O or framing error; a request over the size
+ * limit gets an error reply before the connection is closed.
+ * cli_serve_unix() listens on a Unix domain socket and serves each
+ * connection on its own thread; it only returns on error.
+ */
+int cli_serve_fd(const OptionSpec *spec, int in_fd, int out_fd);
+int cli_serve_unix(const OptionSpec *spec, const char *socket_path);
+
 /*
  * SMARTARGS API - Just declare what you need!
  * 
@@ -57,44 +443,103 @@ void cli_free(ParseResult *result);
 
 /* Smart option definition macros */
 #define FLAG(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_FLAG, &var, help_text, 0}
+    {long_opt, short_opt, OPT_FLAG, &var, help_text, 0, NULL}
 
 #define FLAG_REQUIRED(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_FLAG, &var, help_text, 1}
+    {long_opt, short_opt, OPT_FLAG, &var, help_text, 1, NULL}
+
+#define COUNT(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_COUNT, &var, help_text, 0, NULL}
 
 #define INT(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_INT, &var, help_text, 0}
+    {long_opt, short_opt, OPT_INT, &var, help_text, 0, NULL}
 
 #define INT_REQUIRED(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_INT, &var, help_text, 1}
+    {long_opt, short_opt, OPT_INT, &var, help_text, 1, NULL}
 
 #define STRING(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_STRING, &var, help_text, 0}
+    {long_opt, short_opt, OPT_STRING, &var, help_text, 0, NULL}
 
 #define STRING_REQUIRED(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_STRING, &var, help_text, 1}
+    {long_opt, short_opt, OPT_STRING, &var, help_text, 1, NULL}
+
+#define STRING_VIEW(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_STRING_VIEW, &var, help_text, 0, NULL}
+
+#define STRING_VIEW_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_STRING_VIEW, &var, help_text, 1, NULL}
 
 #define DOUBLE(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_DOUBLE, &var, help_text, 0}
+    {long_opt, short_opt, OPT_DOUBLE, &var, help_text, 0, NULL}
 
 #define DOUBLE_REQUIRED(var, short_opt, long_opt, help_text) \
-    {long_opt, short_opt, OPT_DOUBLE, &var, help_text, 1}
+    {long_opt, short_opt, OPT_DOUBLE, &var, help_text, 1, NULL}
+
+#define INT64(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_INT64, &var, help_text, 0, NULL}
+
+#define INT64_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_INT64, &var, help_text, 1, NULL}
+
+#define UINT64(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_UINT64, &var, help_text, 0, NULL}
+
+#define UINT64_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_UINT64, &var, help_text, 1, NULL}
+
+#define SIZE(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_SIZE, &var, help_text, 0, NULL}
+
+#define SIZE_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_SIZE, &var, help_text, 1, NULL}
+
+#define DURATION(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_DURATION, &var, help_text, 0, NULL}
+
+#define DURATION_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_DURATION, &var, help_text, 1, NULL}
+
+#define INT_LIST(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_INT_LIST, &var, help_text, 0, NULL}
+
+#define INT_LIST_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_INT_LIST, &var, help_text, 1, NULL}
+
+#define DOUBLE_LIST(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_DOUBLE_LIST, &var, help_text, 0, NULL}
+
+#define DOUBLE_LIST_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_DOUBLE_LIST, &var, help_text, 1, NULL}
+
+#define STRING_LIST(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_STRING_LIST, &var, help_text, 0, NULL}
+
+#define STRING_LIST_REQUIRED(var, short_opt, long_opt, help_text) \
+    {long_opt, short_opt, OPT_STRING_LIST, &var, help_text, 1, NULL}
+
+/* Any option with its own environment variable, applied below argv */
+#define OPTION_ENV(type, var, short_opt, long_opt, help_text, env_name) \
+    {long_opt, short_opt, type, &var, help_text, 0, env_name}
 
 /* The magic macro that does everything automatically */
 #define ARGS(argc, argv, description, ...) \
     do { \
         Option _smartargs_options[] = { __VA_ARGS__ }; \
         int _smartargs_option_count = sizeof(_smartargs_options) / sizeof(_smartargs_options[0]); \
+        OptionSpec *_smartargs_spec = cli_compile(_smartargs_options, _smartargs_option_count); \
         ParseResult _smartargs_result; \
         \
-        if (cli_parse(argc, argv, _smartargs_options, _smartargs_option_count, &_smartargs_result) != 0) { \
+        if (cli_parse_spec(_smartargs_spec, argc, argv, &_smartargs_result) != 0) { \
             fprintf(stderr, "Error: %s\n", _smartargs_result.error); \
-            cli_usage(argv[0], _smartargs_options, _smartargs_option_count, description); \
+            cli_spec_usage(_smartargs_spec, argv[0], description); \
             cli_free(&_smartargs_result); \
+            cli_spec_free(_smartargs_spec); \
             exit(1); \
         } \
+        cli_spec_free(_smartargs_spec); \
         \
         /* Store positional arguments in global variables */ \
+        smartargs_result = _smartargs_result; \
         args = _smartargs_result.args; \
         arg_count = _smartargs_result.arg_count; \
         \
@@ -105,46 +550,87 @@ void cli_free(ParseResult *result);
 extern char **args;
 extern int arg_count;
 
+/* The result behind args and any list arrays, released by CLEANUP() */
+extern ParseResult smartargs_result;
+
 /* Smart help macro - automatically shows help if --help is used */
 #define HELP(help_var) \
     FLAG(help_var, 'h', "help", "Show this help message")
 
 /* Complete parsing with automatic help handling - The main SmartArgs macro */
 #define CONFIGURE(argc, argv, description, help_var, ...) \
+    SMARTARGS_CONFIGURE_(0, argc, argv, description, help_var, __VA_ARGS__)
+
+/* CONFIGURE printing a one-line --help hint on errors instead of the usage */
+#define CONFIGURE_HINT(argc, argv, description, help_var, ...) \
+    SMARTARGS_CONFIGURE_(1, argc, argv, description, help_var, __VA_ARGS__)
+
+#define SMARTARGS_CONFIGURE_(hint, argc, argv, description, help_var, ...) \
     do { \
         Option _smartargs_options[] = { \
             HELP(help_var), \
             __VA_ARGS__ \
         }; \
         int _smartargs_option_count = sizeof(_smartargs_options) / sizeof(_smartargs_options[0]); \
+        OptionSpec *_smartargs_spec = cli_compile(_smartargs_options, _smartargs_option_count); \
         ParseResult _smartargs_result; \
         \
-        if (cli_parse(argc, argv, _smartargs_options, _smartargs_option_count, &_smartargs_result) != 0) { \
-            fprintf(stderr, "Error: %s\n", _smartargs_result.error); \
-            cli_usage(argv[0], _smartargs_options, _smartargs_option_count, description); \
+        if (cli_parse_spec(_smartargs_spec, argc, argv, &_smartargs_result) != 0) { \
+            if (hint) { \
+                cli_usage_hint(_smartargs_spec, argv[0], _smartargs_result.error); \
+            } else { \
+                fprintf(stderr, "Error: %s\n", _smartargs_result.error); \
+                cli_spec_usage(_smartargs_spec, argv[0], description); \
+            } \
             cli_free(&_smartargs_result); \
+            cli_spec_free(_smartargs_spec); \
             exit(1); \
         } \
         \
         if (help_var) { \
-            cli_usage(argv[0], _smartargs_options, _smartargs_option_count, description); \
+            cli_spec_usage(_smartargs_spec, argv[0], description); \
             cli_free(&_smartargs_result); \
+            cli_spec_free(_smartargs_spec); \
             exit(0); \
         } \
+        cli_spec_free(_smartargs_spec); \
         \
+        smartargs_result = _smartargs_result; \
         args = _smartargs_result.args; \
         arg_count = _smartargs_result.arg_count; \
     } while(0)
 
-/* Cleanup macro */
+/*
+ * Status-returning flavours of ARGS and CONFIGURE for code that must not
+ * exit, such as worker threads. They store 0 in status on success, 1 when
+ * help was shown or ctx->on_positional stopped the parse, and -1 on error
+ * (see ctx->error). Positionals stay in ctx->result until cli_ctx_free().
+ */
+#define TRY_ARGS(status, ctx, argc, argv, description, ...) \
+    do { \
+        Option _smartargs_options[] = { __VA_ARGS__ }; \
+        int _smartargs_option_count = sizeof(_smartargs_options) / sizeof(_smartargs_options[0]); \
+        (status) = cli_configure_ctx(ctx, argc, argv, _smartargs_options, _smartargs_option_count, \
+                                     description); \
+    } while(0)
+
+#define TRY_CONFIGURE(status, ctx, argc, argv, description, help_var, ...) \
+    do { \
+        Option _smartargs_options[] = { \
+            HELP(help_var), \
+            __VA_ARGS__ \
+        }; \
+        int _smartargs_option_count = sizeof(_smartargs_options) / sizeof(_smartargs_options[0]); \
+        (status) = cli_configure_ctx(ctx, argc, argv, _smartargs_options, _smartargs_option_count, \
+                                     description); \
+    } while(0)
+
+/* Cleanup macro: frees args and the list arrays of ARGS or CONFIGURE */
 #define CLEANUP() \
     do { \
-        if (args) { \
-            ParseResult _temp = {args, arg_count, NULL}; \
-            cli_free(&_temp); \
-            args = NULL; \
-            arg_count = 0; \
-        } \
+        cli_free(&smartargs_result); \
+        args = NULL; \
+        arg_count = 0; \
     } while(0)
 
 #ifdef __cplusplus
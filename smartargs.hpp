@@ -0,0 +1,599 @@
+#ifndef SMARTARGS_HPP
+#define SMARTARGS_HPP
+
+/*
+ * SmartArgs C++ front-end (C++17, header-only)
+ *
+ * The option set is a constexpr value whose option types are template
+ * parameters, so a table with a duplicate name does not compile, long
+ * names are found through a hash table built at compile time, and every
+ * value is written through a reference of its own type:
+ *
+ *     constexpr auto cli = smartargs::make_spec(
+ *         smartargs::flag('v', "verbose", "Verbose output"),
+ *         smartargs::option<int>('t', "threads", "Worker threads"),
+ *         smartargs::option<std::string_view>('n', "name", "Job name").required(),
+ *         smartargs::option<std::vector<int>>('i', "ids", "Ids, comma-separated"));
+ *
+ *     bool verbose = false;
+ *     int threads = 4;
+ *     std::string_view name;
+ *     std::vector<int> ids;
+ *     smartargs::Result result = cli.parse(argc, argv, verbose, threads, name, ids);
+ *
+ * Values may be bool (flags only), any integer or floating point type,
+ * std::string_view, const char *, std::string, std::optional of those, or
+ * std::vector of those (numbers split on commas, every occurrence appends).
+ * Syntax and error codes follow the C library; nothing here needs linking.
+ * As there, a flag named "help" (or else the first flag with short name 'h')
+ * skips the check for required options when it is given.
+ *
+ * The table is checked at compile time when make_spec() is consteval
+ * (C++20) or, in C++17, when its result initializes a constexpr variable
+ * as above. A table built at run time in C++17 aborts instead.
+ */
+
+#include "smartargs.h"
+
+#include <array>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartargs {
+
+/* Outcome of Spec::parse(); positionals point into argv */
+struct Result {
+    CliErrorCode code = CLI_OK;
+    const char *message = nullptr;      /* Same texts as the C library */
+    int index = -1;                     /* argv index of the offending token, -1 if none */
+    std::string_view option;            /* Long name of the option involved, if any */
+    std::vector<std::string_view> args;
+
+    explicit operator bool() const { return code == CLI_OK; }
+};
+
+/* One option; T is the type of the variable it writes */
+template <typename T>
+struct Option {
+    using type = T;
+    char short_name;
+    std::string_view long_name;
+    std::string_view help;
+    bool is_required;
+
+    constexpr Option required() const {
+        Option copy = *this;
+        copy.is_required = true;
+        return copy;
+    }
+};
+
+template <typename T>
+constexpr Option<T> option(char short_name, std::string_view long_name, std::string_view help) {
+    static_assert(!std::is_same_v<T, bool>, "use smartargs::flag() for bool options");
+    return Option<T>{short_name, long_name, help, false};
+}
+
+constexpr Option<bool> flag(char short_name, std::string_view long_name, std::string_view help) {
+    return Option<bool>{short_name, long_name, help, false};
+}
+
+namespace detail {
+
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+template <typename T> struct is_vector : std::false_type {};
+template <typename T, typename A> struct is_vector<std::vector<T, A>> : std::true_type {};
+template <typename T> struct dependent_false : std::false_type {};
+
+/* The scalar a value is converted to: T itself, or what an optional or vector holds */
+template <typename T, typename = void> struct element { using type = T; };
+template <typename T>
+struct element<T, std::enable_if_t<is_optional<T>::value || is_vector<T>::value>> {
+    using type = typename element<typename T::value_type>::type;
+};
+template <typename T> using element_t = typename element<T>::type;
+
+/* FNV-1a, as in the C library */
+constexpr std::uint32_t hash(std::string_view name) {
+    std::uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Slots for an open-addressed table of n names: a power of two, at least 2n */
+constexpr std::size_t slot_count(std::size_t n) {
+    std::size_t slots = 2;
+    while (slots < 2 * n) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+/*
+ * A table that breaks these rules fails to compile: the call to a
+ * non-constexpr function names the problem in the compiler error.
+ */
+inline void duplicate_long_name() { std::abort(); }
+inline void duplicate_short_name() { std::abort(); }
+inline void invalid_long_name() { std::abort(); }
+
+/* Integer with an optional sign and 0x, 0o or 0b prefix; all of s is used */
+template <typename T>
+CliErrorCode parse_integer(std::string_view s, T &out) {
+    bool negative = !s.empty() && s[0] == '-';
+    if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+        s.remove_prefix(1);
+    }
+    int base = 10;
+    if (s.size() > 2 && s[0] == '0') {
+        char prefix = static_cast<char>(s[1] | 0x20);
+        base = prefix == 'x' ? 16 : prefix == 'o' ? 8 : prefix == 'b' ? 2 : 10;
+        if (base != 10) {
+            s.remove_prefix(2);
+        }
+    }
+    unsigned long long magnitude = 0;
+    const char *end = s.data() + s.size();
+    auto parsed = std::from_chars(s.data(), end, magnitude, base);
+    if (s.empty() || parsed.ec == std::errc::invalid_argument || parsed.ptr != end) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    if (parsed.ec == std::errc::result_out_of_range) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+
+    using U = unsigned long long;
+    if constexpr (std::is_signed_v<T>) {
+        U limit = negative ? U(std::numeric_limits<T>::max()) + 1 : U(std::numeric_limits<T>::max());
+        if (magnitude > limit) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        out = negative ? T(-static_cast<long long>(magnitude - 1) - 1) : T(magnitude);
+    } else {
+        if ((negative && magnitude != 0) || magnitude > U(std::numeric_limits<T>::max())) {
+            return CLI_ERR_OUT_OF_RANGE;
+        }
+        out = T(magnitude);
+    }
+    return CLI_OK;
+}
+
+/*
+ * Decimal, hex (0x1.8p3), inf and nan, as strtod() reads them; overflow and
+ * underflow are range errors. Locale-independent where std::from_chars
+ * supports floating point.
+ */
+template <typename T>
+CliErrorCode parse_floating(std::string_view s, T &out) {
+    if (!s.empty() && s[0] == '+' && (s.size() == 1 || s[1] != '-')) {
+        s.remove_prefix(1);
+    }
+    double value = 0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    bool negative = !s.empty() && s[0] == '-';
+    std::string_view digits = s.substr(negative ? 1 : 0);
+    std::chars_format format = std::chars_format::general;
+    if (digits.size() > 2 && digits[0] == '0' && (digits[1] | 0x20) == 'x') {
+        digits.remove_prefix(2);    /* from_chars reads hex without the prefix */
+        format = std::chars_format::hex;
+    }
+    if (digits.empty() || digits[0] == '-' || digits[0] == '+') {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    const char *end = digits.data() + digits.size();
+    auto parsed = std::from_chars(digits.data(), end, value, format);
+    if (parsed.ec == std::errc::invalid_argument || parsed.ptr != end) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    if (parsed.ec == std::errc::result_out_of_range) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+    value = negative ? -value : value;
+#else
+    std::string text(s);
+    char *end_ptr = nullptr;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end_ptr);
+    if (text.empty() || end_ptr != text.c_str() + text.size()) {
+        return CLI_ERR_INVALID_VALUE;
+    }
+    if (errno == ERANGE) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+#endif
+    if (std::isfinite(value) && std::fabs(value) > double(std::numeric_limits<T>::max())) {
+        return CLI_ERR_OUT_OF_RANGE;
+    }
+    out = T(value);
+    return CLI_OK;
+}
+
+/* Convert one value; vectors append, comma-separated for numbers */
+template <typename T>
+CliErrorCode assign(T &target, std::string_view value, const char *text) {
+    if constexpr (is_optional<T>::value) {
+        typename T::value_type item{};
+        CliErrorCode code = assign(item, value, text);
+        if (code == CLI_OK) {
+            target = std::move(item);
+        }
+        return code;
+    } else if constexpr (is_vector<T>::value) {
+        using E = typename T::value_type;
+        if constexpr (std::is_arithmetic_v<E>) {
+            std::size_t old_size = target.size();
+            std::size_t fields = 1;
+            for (char c : value) {
+                fields += c == ',';
+            }
+            target.reserve(old_size + fields);
+            for (;;) {
+                std::size_t comma = value.find(',');
+                E item{};
+                CliErrorCode code = assign(item, value.substr(0, comma), nullptr);
+                if (code != CLI_OK) {
+                    target.resize(old_size);
+                    return code;
+                }
+                target.push_back(item);
+                if (comma == std::string_view::npos) {
+                    return CLI_OK;
+                }
+                value.remove_prefix(comma + 1);
+            }
+        } else {
+            E item{};
+            CliErrorCode code = assign(item, value, text);
+            if (code == CLI_OK) {
+                target.push_back(std::move(item));
+            }
+            return code;
+        }
+    } else if constexpr (std::is_same_v<T, bool>) {
+        static_assert(dependent_false<T>::value, "bool is only written by flags");
+    } else if constexpr (std::is_integral_v<T>) {
+        return parse_integer(value, target);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return parse_floating(value, target);
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+        target = value;
+        return CLI_OK;
+    } else if constexpr (std::is_same_v<T, const char *>) {
+        target = text;      /* values come from argv, so they are NUL-terminated */
+        return CLI_OK;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        target.assign(value.data(), value.size());
+        return CLI_OK;
+    } else {
+        static_assert(dependent_false<T>::value, "unsupported option type");
+    }
+}
+
+template <typename T>
+constexpr const char *error_message(CliErrorCode code) {
+    using E = element_t<T>;
+    if constexpr (std::is_floating_point_v<E>) {
+        return code == CLI_ERR_INVALID_VALUE ? "Invalid double value" : "Double value out of range";
+    } else {
+        return code == CLI_ERR_INVALID_VALUE ? "Invalid integer value" : "Integer value out of range";
+    }
+}
+
+template <typename T>
+constexpr const char *type_hint() {
+    using E = element_t<T>;
+    const bool list = is_vector<T>::value;
+    if constexpr (std::is_same_v<T, bool>) {
+        return "";
+    } else if constexpr (std::is_integral_v<E>) {
+        return list ? " <num,...>" : " <num>";
+    } else if constexpr (std::is_floating_point_v<E>) {
+        return list ? " <float,...>" : " <float>";
+    } else {
+        return list ? " <string>..." : " <string>";
+    }
+}
+
+} // namespace detail
+
+/* A validated option table; build it with make_spec() */
+template <typename... Opts>
+class Spec {
+public:
+    static constexpr std::size_t size = sizeof...(Opts);
+
+    constexpr explicit Spec(const Opts &...opts)
+        : short_names_{opts.short_name...},
+          long_names_{opts.long_name...},
+          help_{opts.help...},
+          required_{opts.is_required...},
+          hashes_{detail::hash(opts.long_name)...},
+          slots_{},
+          help_index_(-1) {
+        for (auto &slot : slots_) {
+            slot = -1;
+        }
+        int help_short = -1;
+        for (std::size_t i = 0; i < size; i++) {
+            std::string_view name = long_names_[i];
+            if (is_flag(int(i))) {
+                if (help_index_ < 0 && name == "help") {
+                    help_index_ = int(i);
+                } else if (help_short < 0 && short_names_[i] == 'h') {
+                    help_short = int(i);
+                }
+            }
+            if (!name.empty() && (name[0] == '-' || name.find('=') != std::string_view::npos)) {
+                detail::invalid_long_name();
+            }
+            for (std::size_t j = 0; j < i; j++) {
+                if (!name.empty() && name == long_names_[j]) {
+                    detail::duplicate_long_name();
+                }
+                if (short_names_[i] && short_names_[i] == short_names_[j]) {
+                    detail::duplicate_short_name();
+                }
+            }
+            if (!name.empty()) {
+                std::size_t slot = hashes_[i] & (slot_count - 1);
+                while (slots_[slot] >= 0) {
+                    slot = (slot + 1) & (slot_count - 1);
+                }
+                slots_[slot] = int(i);
+            }
+        }
+        if (help_index_ < 0) {
+            help_index_ = help_short;
+        }
+    }
+
+    /* Parse argv into refs, one variable per option in declaration order */
+    template <typename... Refs>
+    Result parse(int argc, char *const argv[], Refs &...refs) const {
+        static_assert(sizeof...(Refs) == size, "pass one variable per option");
+        static_assert((std::is_same_v<Refs, typename Opts::type> && ...),
+                      "each variable must have the type of its option");
+        Result result;
+        std::array<bool, size> seen{};
+        auto targets = std::tie(refs...);
+
+        for (int i = 1; i < argc; i++) {
+            const char *data = argv[i];
+            if (!data) {
+                return fail(result, CLI_ERR_INVALID_ARGUMENTS, "NULL argument encountered", i, -1);
+            }
+            std::string_view arg(data);
+
+            if (arg == "--") {
+                for (int j = i + 1; j < argc; j++) {
+                    result.args.emplace_back(argv[j] ? argv[j] : "");
+                }
+                break;
+            }
+
+            /* Long option --name or --name=value */
+            if (arg.size() > 2 && arg[0] == '-' && arg[1] == '-') {
+                std::string_view name = arg.substr(2);
+                std::size_t equals = name.find('=');
+                const char *value = equals != std::string_view::npos ? data + 3 + equals : nullptr;
+                name = name.substr(0, equals);
+
+                int index = find_long(name);
+                if (index < 0) {
+                    return fail(result, CLI_ERR_UNKNOWN_OPTION, "Unknown option", i, -1);
+                }
+                if (is_flag(index) && value) {
+                    return fail(result, CLI_ERR_UNEXPECTED_VALUE, "Flag option does not accept a value", i, index);
+                }
+                if (!is_flag(index) && !value) {
+                    if (i + 1 >= argc || !argv[i + 1]) {
+                        return fail(result, CLI_ERR_MISSING_VALUE, "Option requires a value", i, index);
+                    }
+                    value = argv[++i];
+                }
+                if (!store(targets, seen, result, index, value, i, std::index_sequence_for<Opts...>{})) {
+                    return result;
+                }
+                continue;
+            }
+
+            /* Short options: -x, bundled flags -abc, attached values -t8 */
+            if (arg.size() > 1 && arg[0] == '-') {
+                for (std::size_t k = 1; k < arg.size(); k++) {
+                    int index = find_short(arg[k], std::index_sequence_for<Opts...>{});
+                    if (index < 0) {
+                        return fail(result, CLI_ERR_UNKNOWN_OPTION, "Unknown option", i, -1);
+                    }
+                    const char *value = nullptr;
+                    if (!is_flag(index)) {
+                        if (k + 1 < arg.size()) {
+                            value = data + k + 1;
+                        } else if (i + 1 < argc && argv[i + 1]) {
+                            value = argv[++i];
+                        } else {
+                            return fail(result, CLI_ERR_MISSING_VALUE, "Option requires a value", i, index);
+                        }
+                    }
+                    if (!store(targets, seen, result, index, value, i, std::index_sequence_for<Opts...>{})) {
+                        return result;
+                    }
+                    if (value) {
+                        break;
+                    }
+                }
+                continue;
+            }
+
+            result.args.push_back(arg);
+        }
+
+        /* Skip the check if help was requested */
+        bool help_requested = help_index_ >= 0 && seen[std::size_t(help_index_)];
+        for (std::size_t i = 0; i < size && !help_requested; i++) {
+            if (required_[i] && !seen[i]) {
+                return fail(result, CLI_ERR_REQUIRED_MISSING, "Required option missing", -1, int(i));
+            }
+        }
+        return result;
+    }
+
+    /* Usage text in the layout of cli_usage() */
+    std::string usage(std::string_view program, std::string_view description = {}) const {
+        const std::array<const char *, size> hints{detail::type_hint<typename Opts::type>()...};
+        std::size_t column = 0;
+        for (std::size_t i = 0; i < size; i++) {
+            std::size_t width = 8 + long_names_[i].size() + std::string_view(hints[i]).size() + 2;
+            if (width <= 32 && width > column) {
+                column = width;
+            }
+        }
+
+        std::string text = "Usage: ";
+        text.append(program.empty() ? "program" : program);
+        text += " [options] [arguments]\n";
+        if (!description.empty()) {
+            text += '\n';
+            text.append(description);
+            text += '\n';
+        }
+        if (size > 0) {
+            text += "\nOptions:\n";
+        }
+        for (std::size_t i = 0; i < size; i++) {
+            std::size_t start = text.size();
+            text += "  ";
+            if (short_names_[i]) {
+                text += '-';
+                text += short_names_[i];
+                text += long_names_[i].empty() ? "" : ", ";
+            } else {
+                text += "    ";
+            }
+            if (!long_names_[i].empty()) {
+                text += "--";
+                text.append(long_names_[i]);
+                text += hints[i];
+            }
+            std::size_t left = text.size() - start;
+            if (!help_[i].empty() || required_[i]) {
+                if (left + 2 > column) {
+                    text += '\n';
+                    left = 0;
+                }
+                text.append(column - left, ' ');
+                text.append(help_[i]);
+                text += required_[i] ? (help_[i].empty() ? "(required)" : " (required)") : "";
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+private:
+    std::array<char, size> short_names_;
+    std::array<std::string_view, size> long_names_;
+    std::array<std::string_view, size> help_;
+    std::array<bool, size> required_;
+    std::array<std::uint32_t, size> hashes_;
+
+    /* Option index per slot, -1 if empty; long names probe linearly from their hash */
+    static constexpr std::size_t slot_count = detail::slot_count(size);
+    std::array<int, slot_count> slots_;
+    int help_index_;        /* -1 when the table has no help flag */
+
+    static constexpr bool is_flag(int index) {
+        constexpr std::array<bool, size> flags{std::is_same_v<typename Opts::type, bool>...};
+        return flags[std::size_t(index)];
+    }
+
+    Result &fail(Result &result, CliErrorCode code, const char *message, int index, int option) const {
+        result.code = code;
+        result.message = message;
+        result.index = index;
+        result.option = option >= 0 ? long_names_[std::size_t(option)] : std::string_view();
+        return result;
+    }
+
+    /* Probes from the hash until the name or an empty slot; the table is at most half full */
+    int find_long(std::string_view name) const {
+        const std::uint32_t h = detail::hash(name);
+        for (std::size_t slot = h & (slot_count - 1);; slot = (slot + 1) & (slot_count - 1)) {
+            int index = slots_[slot];
+            if (index < 0 || (hashes_[std::size_t(index)] == h && long_names_[std::size_t(index)] == name)) {
+                return index;
+            }
+        }
+    }
+
+    template <std::size_t... I>
+    int find_short(char name, std::index_sequence<I...>) const {
+        int found = -1;
+        ((found < 0 && short_names_[I] == name ? (found = int(I)) : 0), ...);
+        return found;
+    }
+
+    /* Write value (NULL for a flag) to the variable of option index through its own type */
+    template <typename Targets, std::size_t... I>
+    bool store(Targets &targets, std::array<bool, size> &seen, Result &result, int index,
+               const char *value, int token, std::index_sequence<I...>) const {
+        bool ok = true;
+        ((std::size_t(index) == I ? (ok = store_one<I>(std::get<I>(targets), seen, result, value, token)) : 0), ...);
+        return ok;
+    }
+
+    template <std::size_t I, typename T>
+    bool store_one(T &target, std::array<bool, size> &seen, Result &result, const char *value, int token) const {
+        if constexpr (std::is_same_v<T, bool>) {
+            (void)value;
+            target = true;
+        } else {
+            if constexpr (detail::is_vector<T>::value) {
+                if (!seen[I]) {
+                    target.clear();     /* the first occurrence replaces the default */
+                }
+            }
+            CliErrorCode code = detail::assign(target, std::string_view(value), value);
+            if (code != CLI_OK) {
+                fail(result, code, detail::error_message<T>(code), token, int(I));
+                return false;
+            }
+        }
+        seen[I] = true;
+        return true;
+    }
+};
+
+/*
+ * Validated at compile time: always in C++20, where make_spec() is consteval,
+ * and in C++17 when the result initializes a constexpr variable. Otherwise a
+ * bad table calls std::abort() when it is built.
+ */
+#if defined(__cpp_consteval) && __cpp_consteval >= 201811L
+#define SMARTARGS_CONSTEVAL consteval
+#else
+#define SMARTARGS_CONSTEVAL constexpr
+#endif
+
+template <typename... Opts>
+SMARTARGS_CONSTEVAL Spec<Opts...> make_spec(const Opts &...opts) {
+    return Spec<Opts...>(opts...);
+}
+
+} // namespace smartargs
+
+#endif /* SMARTARGS_HPP */
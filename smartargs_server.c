@@ -0,0 +1,493 @@
+#define _GNU_SOURCE  /* MSG_NOSIGNAL */
+#include "smartargs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVER_READ_SIZE 65536
+#define SERVER_MAX_REQUEST (16 << 20)   /* bytes buffered for one request */
+#define SERVER_MAX_TOKENS 1000000
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* Growable byte buffer; failed sticks once an allocation fails */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} Buffer;
+
+static int buffer_reserve(Buffer *b, size_t extra) {
+    if (b->failed) {
+        return -1;
+    }
+    if (b->len + extra > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->len + extra) {
+            cap *= 2;
+        }
+        char *data = realloc(b->data, cap);
+        if (!data) {
+            b->failed = 1;
+            return -1;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    return 0;
+}
+
+static void buffer_append(Buffer *b, const char *s, size_t n) {
+    if (buffer_reserve(b, n) == 0) {
+        memcpy(b->data + b->len, s, n);
+        b->len += n;
+    }
+}
+
+static void buffer_puts(Buffer *b, const char *s) {
+    buffer_append(b, s, strlen(s));
+}
+
+static void buffer_json_string(Buffer *b, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    buffer_append(b, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer_append(b, s + run, i - run);
+        run = i + 1;
+        if (c == '"' || c == '\\') {
+            char escaped[2] = {'\\', (char)c};
+            buffer_append(b, escaped, 2);
+        } else {
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            buffer_append(b, escaped, 6);
+        }
+    }
+    buffer_append(b, s + run, n - run);
+    buffer_append(b, "\"", 1);
+}
+
+/* State of one served stream */
+typedef struct {
+    const OptionSpec *spec;
+    const Option *options;
+    int option_count;
+    OptionValue *defaults;  /* Option variables when serving started */
+    OptionValue *values;
+    char **argv;
+    int argv_cap;
+    Buffer in;
+    Buffer out;
+} Server;
+
+static size_t value_size(OptionType type) {
+    switch (type) {
+        case OPT_FLAG:
+        case OPT_INT:
+        case OPT_COUNT:
+            return sizeof(int);
+        case OPT_INT64:
+        case OPT_DURATION:
+            return sizeof(int64_t);
+        case OPT_UINT64:
+            return sizeof(uint64_t);
+        case OPT_SIZE:
+            return sizeof(size_t);
+        case OPT_DOUBLE:
+            return sizeof(double);
+        case OPT_STRING:
+            return sizeof(const char*);
+        case OPT_STRING_VIEW:
+            return sizeof(StringView);
+        case OPT_INT_LIST:
+            return sizeof(IntList);
+        case OPT_DOUBLE_LIST:
+            return sizeof(DoubleList);
+        case OPT_STRING_LIST:
+            return sizeof(StringList);
+    }
+    return 0;
+}
+
+static void append_double(Buffer *b, double d) {
+    char number[32];
+    if (!isfinite(d)) {
+        buffer_puts(b, "null");
+        return;
+    }
+    snprintf(number, sizeof(number), "%.17g", d);
+    buffer_puts(b, number);
+}
+
+/* List options become JSON arrays */
+static void append_list(Buffer *b, const Option *opt, const OptionValue *value) {
+    char number[32];
+    size_t count = opt->type == OPT_INT_LIST ? value->ints.count :
+                   opt->type == OPT_DOUBLE_LIST ? value->doubles.count : value->strings.count;
+    
+    buffer_append(b, "[", 1);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            buffer_append(b, ",", 1);
+        }
+        if (opt->type == OPT_INT_LIST) {
+            snprintf(number, sizeof(number), "%d", value->ints.items[i]);
+            buffer_puts(b, number);
+        } else if (opt->type == OPT_DOUBLE_LIST) {
+            append_double(b, value->doubles.items[i]);
+        } else {
+            buffer_json_string(b, value->strings.items[i], strlen(value->strings.items[i]));
+        }
+    }
+    buffer_append(b, "]", 1);
+}
+
+static void append_value(Buffer *b, const Option *opt, const OptionValue *value) {
+    char number[32];
+    
+    switch (opt->type) {
+        case OPT_FLAG:
+            buffer_puts(b, value->i ? "true" : "false");
+            return;
+        case OPT_INT:
+        case OPT_COUNT:
+            snprintf(number, sizeof(number), "%d", value->i);
+            break;
+        case OPT_INT64:
+        case OPT_DURATION:
+            snprintf(number, sizeof(number), "%" PRId64, value->i64);
+            break;
+        case OPT_UINT64:
+            snprintf(number, sizeof(number), "%" PRIu64, value->u64);
+            break;
+        case OPT_SIZE:
+            snprintf(number, sizeof(number), "%zu", value->size);
+            break;
+        case OPT_DOUBLE:
+            append_double(b, value->d);
+            return;
+        case OPT_STRING:
+            if (value->s) {
+                buffer_json_string(b, value->s, strlen(value->s));
+            } else {
+                buffer_puts(b, "null");
+            }
+            return;
+        case OPT_STRING_VIEW:
+            if (value->view.data) {
+                buffer_json_string(b, value->view.data, value->view.length);
+            } else {
+                buffer_puts(b, "null");
+            }
+            return;
+        case OPT_INT_LIST:
+        case OPT_DOUBLE_LIST:
+        case OPT_STRING_LIST:
+            append_list(b, opt, value);
+            return;
+        default:
+            buffer_puts(b, "null");
+            return;
+    }
+    buffer_puts(b, number);
+}
+
+static void append_error(Buffer *b, const CliError *error) {
+    char number[32];
+    
+    buffer_puts(b, "{\"status\":-1,\"error\":{\"code\":");
+    snprintf(number, sizeof(number), "%d", (int)error->code);
+    buffer_puts(b, number);
+    buffer_puts(b, ",\"message\":");
+    buffer_json_string(b, error->message, strlen(error->message));
+    buffer_puts(b, ",\"index\":");
+    snprintf(number, sizeof(number), "%d", error->index);
+    buffer_puts(b, number);
+    buffer_puts(b, ",\"option\":");
+    if (error->option) {
+        buffer_json_string(b, error->option, strlen(error->option));
+    } else if (error->short_name) {
+        buffer_json_string(b, &error->short_name, 1);
+    } else {
+        buffer_puts(b, "null");
+    }
+    buffer_puts(b, "}}\n");
+}
+
+/* Parse argv[0..argc) of the current request and append its reply */
+static void answer(Server *s, int argc) {
+    memcpy(s->values, s->defaults, sizeof(OptionValue) * (size_t)s->option_count);
+    
+    static char *no_environment[] = {NULL};
+    ParseContext ctx = {0};
+    ctx.values = s->values;
+    ctx.environment = no_environment;   /* the client's, not the daemon's */
+    if (cli_parse_ctx(&ctx, s->spec, argc, s->argv) != 0) {
+        append_error(&s->out, &ctx.error);
+        cli_ctx_free(&ctx);
+        return;
+    }
+    
+    buffer_puts(&s->out, "{\"status\":0,\"values\":{");
+    int first = 1;
+    for (int i = 0; i < s->option_count; i++) {
+        const Option *opt = &s->options[i];
+        if (!opt->long_name && !opt->short_name) {
+            continue;
+        }
+        if (!first) {
+            buffer_append(&s->out, ",", 1);
+        }
+        first = 0;
+        if (opt->long_name) {
+            buffer_json_string(&s->out, opt->long_name, strlen(opt->long_name));
+        } else {
+            buffer_json_string(&s->out, &opt->short_name, 1);
+        }
+        buffer_append(&s->out, ":", 1);
+        append_value(&s->out, opt, &s->values[i]);
+    }
+    buffer_puts(&s->out, "},\"args\":[");
+    for (int i = 0; i < ctx.result.arg_count; i++) {
+        if (i > 0) {
+            buffer_append(&s->out, ",", 1);
+        }
+        buffer_json_string(&s->out, ctx.result.args[i], strlen(ctx.result.args[i]));
+    }
+    buffer_puts(&s->out, "]}\n");
+    cli_ctx_free(&ctx);
+}
+
+/*
+ * Split the request starting at data into s->argv. Returns the bytes it
+ * spans, 0 if it is not complete yet, or -1 if it is malformed.
+ */
+static long next_request(Server *s, const char *data, size_t len, int *argc) {
+    const char *end = memchr(data, '\0', len);
+    if (!end) {
+        return len > 16 ? -1 : 0;
+    }
+    
+    long count = 0;
+    if (end == data) {
+        return -1;
+    }
+    for (const char *c = data; c < end; c++) {
+        if (*c < '0' || *c > '9' || (count = count * 10 + (*c - '0')) > SERVER_MAX_TOKENS) {
+            return -1;
+        }
+    }
+    
+    if (count >= s->argv_cap) {
+        int cap = s->argv_cap ? s->argv_cap : 16;
+        while (cap <= count) {
+            cap *= 2;
+        }
+        char **argv = realloc(s->argv, sizeof(char*) * (size_t)cap);
+        if (!argv) {
+            return -1;
+        }
+        s->argv = argv;
+        s->argv_cap = cap;
+    }
+    
+    const char *token = end + 1;
+    const char *limit = data + len;
+    for (long i = 0; i < count; i++) {
+        end = token < limit ? memchr(token, '\0', (size_t)(limit - token)) : NULL;
+        if (!end) {
+            return 0;
+        }
+        s->argv[i] = (char*)token;
+        token = end + 1;
+    }
+    s->argv[count] = NULL;
+    *argc = (int)count;
+    return (long)(token - data);
+}
+
+static int write_all(int fd, int is_socket, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = is_socket ? send(fd, data, len, MSG_NOSIGNAL) : write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Every request already buffered is answered before one write of all replies */
+static int serve(Server *s, int in_fd, int out_fd) {
+    struct stat st;
+    int out_is_socket = fstat(out_fd, &st) == 0 && S_ISSOCK(st.st_mode);
+    
+    for (;;) {
+        size_t pos = 0;
+        long used = 0;
+        int argc = 0;
+        while (pos < s->in.len &&
+               (used = next_request(s, s->in.data + pos, s->in.len - pos, &argc)) > 0) {
+            answer(s, argc);
+            pos += (size_t)used;
+        }
+        
+        if (used < 0) {
+            CliError error = {CLI_ERR_INVALID_ARGUMENTS, "Malformed request", -1, NULL, 0, NULL, 0, {NULL}};
+            append_error(&s->out, &error);
+        }
+        if (s->out.failed) {
+            return -1;
+        }
+        if (s->out.len > 0 && write_all(out_fd, out_is_socket, s->out.data, s->out.len) != 0) {
+            return -1;
+        }
+        s->out.len = 0;
+        if (used < 0) {
+            return -1;
+        }
+        
+        if (pos > 0) {
+            memmove(s->in.data, s->in.data + pos, s->in.len - pos);
+            s->in.len -= pos;
+        }
+        if (s->in.len >= SERVER_MAX_REQUEST) {
+            CliError error = {CLI_ERR_INVALID_ARGUMENTS, "Request too large", -1, NULL, 0, NULL, 0, {NULL}};
+            append_error(&s->out, &error);
+            if (!s->out.failed) {
+                write_all(out_fd, out_is_socket, s->out.data, s->out.len);
+            }
+            return -1;
+        }
+        if (buffer_reserve(&s->in, SERVER_READ_SIZE) != 0) {
+            return -1;
+        }
+        
+        ssize_t n = read(in_fd, s->in.data + s->in.len, SERVER_READ_SIZE);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            /* A clean EOF falls between requests */
+            return n == 0 && s->in.len == 0 ? 0 : -1;
+        }
+        s->in.len += (size_t)n;
+    }
+}
+
+int cli_serve_fd(const OptionSpec *spec, int in_fd, int out_fd) {
+    if (!spec || in_fd < 0 || out_fd < 0) {
+        return -1;
+    }
+    
+    Server s;
+    memset(&s, 0, sizeof(Server));
+    s.spec = spec;
+    s.options = cli_spec_options(spec, &s.option_count);
+    
+    size_t values_size = sizeof(OptionValue) * (size_t)(s.option_count > 0 ? s.option_count : 1);
+    s.defaults = calloc(1, values_size);
+    s.values = malloc(values_size);
+    int ret = -1;
+    if (s.defaults && s.values) {
+        for (int i = 0; i < s.option_count; i++) {
+            if (s.options[i].value) {
+                memcpy(&s.defaults[i], s.options[i].value, value_size(s.options[i].type));
+            }
+        }
+        ret = serve(&s, in_fd, out_fd);
+    }
+    
+    free(s.defaults);
+    free(s.values);
+    free(s.argv);
+    free(s.in.data);
+    free(s.out.data);
+    return ret;
+}
+
+typedef struct {
+    const OptionSpec *spec;
+    int fd;
+} Connection;
+
+static void *serve_connection(void *arg) {
+    Connection *conn = arg;
+    cli_serve_fd(conn->spec, conn->fd, conn->fd);
+    close(conn->fd);
+    free(conn);
+    return NULL;
+}
+
+int cli_serve_unix(const OptionSpec *spec, const char *socket_path) {
+    struct sockaddr_un addr;
+    if (!spec || !socket_path || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    
+    /* Replace a stale socket from an earlier run, but nothing else */
+    struct stat st;
+    if (lstat(socket_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(socket_path);
+    }
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        return -1;
+    }
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0) {
+        close(listen_fd);
+        return -1;
+    }
+    
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        
+        pthread_t thread;
+        Connection *conn = malloc(sizeof(Connection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->spec = spec;
+        conn->fd = fd;
+        if (pthread_create(&thread, &attr, serve_connection, conn) != 0) {
+            close(fd);
+            free(conn);
+        }
+    }
+    pthread_attr_destroy(&attr);
+    close(listen_fd);
+    return -1;
+}
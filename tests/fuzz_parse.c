@@ -0,0 +1,196 @@
+/*
+ * SmartArgs Fuzz Harness
+ * libFuzzer entry point for cli_parse: the input is split on NUL bytes into
+ * argv and parsed against a table of every option type, through cli_parse,
+ * a compiled spec (abbreviations, permutation), the views API and a lazy
+ * parse read back through cli_get_value().
+ *
+ * Built with SMARTARGS_FUZZ_STANDALONE it has its own main instead, which
+ * replays the files named on the command line, or without any runs the
+ * built-in seeds and a fixed number of deterministic mutations of them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "smartargs.h"
+
+#define FUZZ_MAX_TOKENS 256
+
+static int verbose, help, threads, level;
+static int64_t offset;
+static uint64_t seed;
+static size_t limit;
+static int64_t timeout;
+static double ratio;
+static const char *name;
+static StringView label;
+static IntList ids;
+static DoubleList weights;
+static StringList tags;
+
+static Option options[] = {
+    HELP(help),
+    FLAG(verbose, 'v', "verbose", "Verbose"),
+    COUNT(level, 'c', "level", "Level"),
+    INT(threads, 't', "threads", "Threads"),
+    INT64(offset, 'o', "offset", "Offset"),
+    UINT64(seed, 0, "seed", "Seed"),
+    SIZE(limit, 'l', "limit", "Limit"),
+    DURATION(timeout, 0, "timeout", "Timeout"),
+    DOUBLE(ratio, 'r', "ratio", "Ratio"),
+    STRING_REQUIRED(name, 'n', "name", "Name"),
+    STRING_VIEW(label, 0, "label", "Label"),
+    INT_LIST(ids, 'i', "ids", "Ids"),
+    DOUBLE_LIST(weights, 'w', "weights", "Weights"),
+    STRING_LIST(tags, 'T', "tag", "Tags"),
+    FLAG(verbose, 0, "verbose-log", "Shares a prefix with --verbose")
+};
+#define OPTION_COUNT ((int)(sizeof(options) / sizeof(options[0])))
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    /* The first byte picks the parse flags, the rest is argv */
+    unsigned flags = data[0] & (CLI_PERMUTE | CLI_PREFIX_MATCH);
+    char *copy = malloc(size);
+    if (!copy) {
+        return 0;
+    }
+    memcpy(copy, data + 1, size - 1);
+    copy[size - 1] = '\0';
+
+    char *argv[FUZZ_MAX_TOKENS + 1];
+    StringView views[FUZZ_MAX_TOKENS + 1];
+    int argc = 1;
+    argv[0] = "fuzz";
+    for (size_t i = 0; i < size - 1 && argc < FUZZ_MAX_TOKENS; argc++) {
+        argv[argc] = copy + i;
+        i += strlen(copy + i) + 1;
+    }
+    for (int i = 0; i < argc; i++) {
+        views[i].data = argv[i];
+        views[i].length = strlen(argv[i]);
+    }
+
+    ParseResult result;
+    cli_parse(argc, argv, options, OPTION_COUNT, &result);
+    cli_free(&result);
+
+    OptionSpec *spec = cli_compile_ex(options, OPTION_COUNT, flags);
+    if (spec) {
+        OptionValue values[OPTION_COUNT];
+        unsigned counts[OPTION_COUNT];
+        ParseContext ctx = {0};
+        ctx.values = values;
+        ctx.counts = counts;
+        memset(values, 0, sizeof(values));
+        cli_parse_views(&ctx, spec, argc, views);
+        cli_ctx_free(&ctx);
+
+        /* Lazy: record, then convert every value */
+        LazyValue lazy[OPTION_COUNT];
+        ParseContext lazy_ctx = {0};
+        lazy_ctx.lazy = lazy;
+        if (cli_parse_views(&lazy_ctx, spec, argc, views) == 0) {
+            for (int i = 0; i < OPTION_COUNT; i++) {
+                cli_get_value(&lazy_ctx, i, &values[i]);
+            }
+        }
+        cli_ctx_free(&lazy_ctx);
+
+        /* Last, as CLI_PERMUTE reorders argv */
+        ParseContext argv_ctx = {0};
+        cli_parse_ctx(&argv_ctx, spec, argc, argv);
+        cli_ctx_free(&argv_ctx);
+        cli_spec_free(spec);
+    }
+    free(copy);
+    return 0;
+}
+
+#ifdef SMARTARGS_FUZZ_STANDALONE
+#define FUZZ_ITERATIONS 20000
+
+#define SEED(text) {text, sizeof(text) - 1}
+
+static const struct {
+    const char *data;
+    size_t size;
+} seeds[] = {
+    SEED("\x00-v\0--threads=8\0-n\0job\0file"),
+    SEED("\x00-vccc\0--level\0--level=2\0-n\0x"),
+    SEED("\x04--verb\0--thr\0""3\0--name=x"),
+    SEED("\x01in\0-vt8\0--\0-x\0--ratio\0""1e400"),
+    SEED("\x00--ids=1,2,,3\0-w\0""0.5,nan\0--tag\0a,b\0--seed=-1"),
+    SEED("\x00--limit=16k\0--timeout=1h30m\0-o\0-9223372036854775808\0=\0--=\0---"),
+    SEED("\x05-\0--label\0--label=\0-l\0-n")
+};
+
+static const char *const dictionary[] = {
+    "-", "--", "=", ",", "-v", "-t", "-n", "--name", "--threads=", "--ids=", "--weights=",
+    "--tag", "--seed", "--limit", "--timeout", "--ratio", "--label=", "--verbose-log", "--verb",
+    "0", "-1", "1e308", "0x7fffffff", "18446744073709551616", "1.5ms", "12G", "nan", "@file"
+};
+
+static uint32_t next_random(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* A seed with a few dictionary tokens, random bytes or separators spliced in */
+static size_t mutate(uint32_t *state, char *out, size_t capacity) {
+    const char *seed_text = seeds[next_random(state) % (sizeof(seeds) / sizeof(seeds[0]))].data;
+    size_t len = 0;
+    out[len++] = (char)(next_random(state) & 0xff);
+    for (int k = 0; k < 24 && len < capacity - 32; k++) {
+        uint32_t r = next_random(state);
+        if (r % 4 == 0) {
+            out[len++] = (char)(r >> 8);
+        } else if (r % 4 == 1) {
+            out[len++] = '\0';
+        } else {
+            const char *token = r % 4 == 2 ? dictionary[(r >> 8) % (sizeof(dictionary) / sizeof(dictionary[0]))]
+                                           : seed_text + 1 + (r >> 8) % 8;
+            size_t n = strlen(token);
+            memcpy(out + len, token, n);
+            len += n;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char *argv[]) {
+    static char buffer[1 << 16];
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            FILE *f = fopen(argv[i], "rb");
+            if (!f) {
+                fprintf(stderr, "Cannot open %s\n", argv[i]);
+                return 1;
+            }
+            size_t len = fread(buffer, 1, sizeof(buffer), f);
+            fclose(f);
+            LLVMFuzzerTestOneInput((const uint8_t*)buffer, len);
+        }
+        return 0;
+    }
+
+    printf("Running SmartArgs Fuzz Replay...\n");
+    for (size_t i = 0; i < sizeof(seeds) / sizeof(seeds[0]); i++) {
+        LLVMFuzzerTestOneInput((const uint8_t*)seeds[i].data, seeds[i].size);
+    }
+    uint32_t state = 2463534242u;
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        size_t len = mutate(&state, buffer, sizeof(buffer));
+        LLVMFuzzerTestOneInput((const uint8_t*)buffer, len);
+    }
+    printf("✅ %d fuzz inputs parsed without a crash!\n", FUZZ_ITERATIONS);
+    return 0;
+}
+#endif
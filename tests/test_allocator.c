@@ -0,0 +1,142 @@
+/*
+ * SmartArgs Allocator Test
+ * Parses through a caller's allocator, which must see every block of the
+ * result and get every one back, and through a bump arena: released by a
+ * reset, with a budget that fails the parse instead of growing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define POSITIONALS 1000
+
+typedef struct {
+    int live;
+    int calls;
+} Counter;
+
+static void *counted_alloc(void *userdata, size_t size) {
+    Counter *c = userdata;
+    c->live++;
+    c->calls++;
+    return malloc(size);
+}
+
+static void *counted_realloc(void *userdata, void *ptr, size_t size) {
+    Counter *c = userdata;
+    c->live += ptr == NULL;
+    c->calls++;
+    return realloc(ptr, size);
+}
+
+static void counted_free(void *userdata, void *ptr) {
+    Counter *c = userdata;
+    c->live--;
+    free(ptr);
+}
+
+static char dir[] = "/tmp/smartargs_allocator_XXXXXX";
+
+static char *write_file(const char *name, const char *contents) {
+    static char paths[2][256];
+    static int next = 0;
+    char *path = paths[next++ % 2];
+    snprintf(path, sizeof(paths[0]), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fputs(contents, f);
+    fclose(f);
+    return path;
+}
+
+int main() {
+    printf("Running SmartArgs Allocator Test...\n");
+    assert(mkdtemp(dir) != NULL);
+
+    int threads = 0;
+    const char *name = NULL;
+    IntList ids = {NULL, 0};
+    Option options[] = {
+        INT(threads, 't', "threads", "Threads"),
+        STRING(name, 'n', "name", "Name"),
+        INT_LIST(ids, 'i', "ids", "Ids")
+    };
+    OptionSpec *spec = cli_compile_ex(options, 3, CLI_RESPONSE_FILES);
+    char *config = write_file("app.ini", "name = config\nids = 7,8\n");
+    char rsp_token[300];
+    snprintf(rsp_token, sizeof(rsp_token), "@%s", write_file("args.rsp", "--threads=6 from-file"));
+
+    static char *argv[POSITIONALS + 4];
+    static char words[POSITIONALS][8];
+    argv[0] = "app";
+    argv[1] = rsp_token;
+    argv[2] = "-i1,2,3";
+    for (int i = 0; i < POSITIONALS; i++) {
+        snprintf(words[i], sizeof(words[i]), "w%d", i);
+        argv[3 + i] = words[i];
+    }
+    int argc = POSITIONALS + 3;
+
+    // Every block comes from the allocator and goes back to it
+    Counter counter = {0, 0};
+    CliAllocator allocator = {counted_alloc, counted_realloc, counted_free, &counter};
+    ParseContext ctx = {0};
+    ctx.allocator = &allocator;
+    ctx.config_path = config;
+    assert(cli_parse_ctx(&ctx, spec, argc, argv) == 0);
+    assert(threads == 6 && strcmp(name, "config") == 0 && ids.count == 3);
+    assert(ctx.result.arg_count == POSITIONALS + 1 && strcmp(ctx.result.args[0], "from-file") == 0);
+    assert(counter.calls > 0 && counter.live > 0);
+    cli_ctx_free(&ctx);
+    assert(counter.live == 0);
+
+    // A bump arena: the whole result is in the buffer and a reset frees it
+    static char buffer[256 * 1024];
+    CliBumpArena arena;
+    assert(cli_arena_init(&arena, buffer, sizeof(buffer)) == 0);
+    ctx.allocator = &arena.allocator;
+    for (int round = 0; round < 3; round++) {
+        name = NULL;
+        assert(cli_parse_ctx(&ctx, spec, argc, argv) == 0);
+        assert(threads == 6 && ids.count == 3 && ids.items[2] == 3);
+        assert(name >= arena.base && name < arena.base + arena.size);   /* config read into the arena */
+        assert((char*)ctx.result.args >= arena.base && (char*)ctx.result.args < arena.base + arena.size);
+        assert(strcmp(ctx.result.args[POSITIONALS], "w999") == 0);
+        assert(arena.used > 0 && arena.used <= arena.peak);
+        cli_arena_reset(&arena);
+        assert(arena.used == 0);
+    }
+
+    // A misaligned buffer is aligned inside, and is still the caller's
+    CliBumpArena skewed;
+    assert(cli_arena_init(&skewed, buffer + 1, 1024) == 0);
+    assert((uintptr_t)skewed.base % 16 == 0 && skewed.base > buffer && skewed.owned == NULL);
+    cli_arena_destroy(&skewed);
+
+    // Over budget the parse fails cleanly; the next one can reuse the arena
+    CliBumpArena small;
+    assert(cli_arena_init(&small, NULL, 4096) == 0);
+    assert(small.owned != NULL && (uintptr_t)small.base % 16 == 0);
+    ctx.allocator = &small.allocator;
+    assert(cli_parse_ctx(&ctx, spec, argc, argv) == -1);
+    assert(ctx.error.code == CLI_ERR_NO_MEMORY);
+    assert(small.peak <= small.size);
+    cli_arena_reset(&small);
+    ctx.config_path = NULL;
+    assert(cli_parse_ctx(&ctx, spec, 40, argv) == 0 && ctx.result.arg_count == 38);
+    cli_arena_reset(&small);
+    cli_arena_destroy(&small);
+
+    cli_spec_free(spec);
+    unlink(config);
+    snprintf(rsp_token, sizeof(rsp_token), "%s/args.rsp", dir);
+    unlink(rsp_token);
+    rmdir(dir);
+    printf("✅ All allocator tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * SmartArgs Batch Parsing Test
+ * Parses many argument vectors against one spec on a thread pool and checks
+ * that every result lands in input order with its own option values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define VECTOR_COUNT 20000
+
+typedef struct {
+    char *argv[6];
+    char threads[16];
+    char name[32];
+} Vector;
+
+int main() {
+    printf("Running SmartArgs Batch Parsing Test...\n");
+
+    int verbose = 0;
+    int threads = -1;
+    const char *name = NULL;
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(threads, 't', "threads", "Threads"),
+        STRING_REQUIRED(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile(options, 3);
+    assert(spec != NULL);
+
+    // Every 7th vector has a bad integer, every 11th lacks the required name
+    Vector *vectors = calloc(VECTOR_COUNT, sizeof(Vector));
+    static int argcs[VECTOR_COUNT];
+    static char **argvs[VECTOR_COUNT];
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        Vector *v = &vectors[i];
+        snprintf(v->threads, sizeof(v->threads), i % 7 == 3 ? "x%d" : "%d", i);
+        snprintf(v->name, sizeof(v->name), "--name=job-%d", i);
+        int n = 0;
+        v->argv[n++] = "job";
+        if (i % 2) v->argv[n++] = "-v";
+        v->argv[n++] = "--threads";
+        v->argv[n++] = v->threads;
+        if (i % 11 != 5) v->argv[n++] = v->name;
+        v->argv[n++] = i % 3 ? "input" : "--";
+        argcs[i] = n;
+        argvs[i] = v->argv;
+    }
+
+    int thread_counts[] = {1, 4, 0};
+    for (int t = 0; t < 3; t++) {
+        BatchResult batch;
+        assert(cli_parse_batch(spec, VECTOR_COUNT, argcs, argvs, thread_counts[t], &batch) == 0);
+        assert(batch.count == VECTOR_COUNT);
+
+        int failed = 0;
+        for (int i = 0; i < VECTOR_COUNT; i++) {
+            BatchItem *item = &batch.items[i];
+            if (i % 7 == 3) {
+                assert(item->status == -1);
+                assert(item->error.code == CLI_ERR_INVALID_VALUE);
+                assert(item->error.index == (i % 2 ? 3 : 2));
+                failed++;
+                continue;
+            }
+            if (i % 11 == 5) {
+                assert(item->status == -1);
+                assert(item->error.code == CLI_ERR_REQUIRED_MISSING);
+                assert(strcmp(item->error.option, "name") == 0);
+                failed++;
+                continue;
+            }
+            assert(item->status == 0);
+            assert(item->values[0].i == i % 2);
+            assert(item->values[1].i == i);
+            assert(strcmp(item->values[2].s, vectors[i].name + 7) == 0);
+            assert(item->arg_count == (i % 3 ? 1 : 0));
+            if (item->arg_count) {
+                assert(item->args[0] == vectors[i].argv[argcs[i] - 1]);
+            }
+        }
+        assert(batch.failed == failed);
+        cli_batch_free(&batch);
+        assert(batch.items == NULL);
+    }
+
+    // The Option variables are never written by a batch
+    assert(verbose == 0 && threads == -1 && name == NULL);
+
+    // Environment fallbacks apply below each item's argv
+    int level = 0;
+    Option env_options[] = {
+        OPTION_ENV(OPT_INT, level, 'l', "level", "Level", "SMARTARGS_BATCH_LEVEL")
+    };
+    OptionSpec *env_spec = cli_compile(env_options, 1);
+    assert(env_spec != NULL);
+    setenv("SMARTARGS_BATCH_LEVEL", "7", 1);
+    char *env_given[] = {"job", "-l2"};
+    char *env_missing[] = {"job"};
+    int env_argcs[] = {2, 1};
+    char **env_argvs[] = {env_given, env_missing};
+    BatchResult env_batch;
+    assert(cli_parse_batch(env_spec, 2, env_argcs, env_argvs, 2, &env_batch) == 0);
+    assert(env_batch.failed == 0);
+    assert(env_batch.items[0].values[0].i == 2 && env_batch.items[1].values[0].i == 7);
+    assert(level == 0);
+    cli_batch_free(&env_batch);
+    unsetenv("SMARTARGS_BATCH_LEVEL");
+    cli_spec_free(env_spec);
+
+    // An empty batch is valid
+    BatchResult empty;
+    assert(cli_parse_batch(spec, 0, NULL, NULL, 0, &empty) == 0);
+    assert(empty.count == 0 && empty.failed == 0);
+    cli_batch_free(&empty);
+
+    cli_spec_free(spec);
+    free(vectors);
+
+    printf("✅ All batch parsing tests passed!\n");
+    return 0;
+}
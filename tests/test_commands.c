@@ -0,0 +1,162 @@
+/*
+ * SmartArgs Subcommand Test
+ * Dispatches on the command name, parses global and command options into
+ * their own tables and checks unknown commands, error indexes and usage.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define COMMAND_COUNT 80
+
+static int verbose, help, all, depth = 1, force;
+static const char *dir = NULL, *message = NULL, *remote = NULL;
+
+static Option global[] = {
+    HELP(help),
+    FLAG(verbose, 'v', "verbose", "Verbose output"),
+    STRING(dir, 'C', "dir", "Run as if started in dir")
+};
+static Option commit_options[] = {
+    FLAG(all, 'a', "all", "Commit all changed files"),
+    STRING_REQUIRED(message, 'm', "message", "Commit message")
+};
+static Option fetch_options[] = {
+    INT(depth, 0, "depth", "History depth"),
+    FLAG(force, 'f', "force", "Overwrite local refs"),
+    STRING(remote, 0, "remote", "Remote name")
+};
+
+static char names[COMMAND_COUNT][16];
+static Command commands[COMMAND_COUNT];
+
+static int parse(const CommandSet *set, ParseContext *ctx, int argc, char **argv) {
+    verbose = all = force = 0;
+    depth = 1;
+    dir = message = remote = NULL;
+    cli_ctx_free(ctx);
+    return cli_parse_command(ctx, set, argc, argv);
+}
+
+static int starts_with(const char *text, const char *prefix) {
+    return strncmp(text, prefix, strlen(prefix)) == 0;
+}
+
+static char *capture_usage(const CommandSet *set, int command) {
+    static char text[8192];
+    char path[] = "/tmp/smartargs_commands_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    fflush(NULL);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    if (command < 0) {
+        cli_commands_usage(set, "vcs", "A version control tool.");
+    } else {
+        cli_command_usage(set, command, "vcs");
+    }
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    ssize_t len = pread(fd, text, sizeof(text) - 1, 0);
+    assert(len >= 0);
+    text[len] = '\0';
+    close(fd);
+    unlink(path);
+    return text;
+}
+
+int main() {
+    printf("Running SmartArgs Subcommand Test...\n");
+    setenv("COLUMNS", "80", 1);
+
+    /* commit and fetch among many commands without options */
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "command-%02d", i);
+        Command c = {names[i], NULL, NULL, 0, NULL};
+        commands[i] = c;
+    }
+    Command commit = {"commit", "Record changes", commit_options, 2, "Records changes to the repository."};
+    Command fetch = {"fetch", "Download objects and refs", fetch_options, 3, NULL};
+    commands[10] = commit;
+    commands[42] = fetch;
+    CommandSet *set = cli_commands_compile(global, 3, commands, COMMAND_COUNT);
+    assert(set != NULL);
+    ParseContext ctx = {0};
+
+    // Global options before the command, command options after it
+    char *argv1[] = {"vcs", "-v", "--dir", "/src", "commit", "-am", "fix", "file.c"};
+    assert(parse(set, &ctx, 8, argv1) == 10);
+    assert(verbose && strcmp(dir, "/src") == 0);
+    assert(all && strcmp(message, "fix") == 0);
+    assert(ctx.result.arg_count == 1 && strcmp(ctx.result.args[0], "file.c") == 0);
+
+    char *argv2[] = {"vcs", "fetch", "--depth=3", "origin"};
+    assert(parse(set, &ctx, 4, argv2) == 42 && depth == 3 && !verbose);
+    assert(ctx.result.arg_count == 1 && strcmp(ctx.result.args[0], "origin") == 0);
+    char *argv3[] = {"vcs", "command-07"};
+    assert(parse(set, &ctx, 2, argv3) == 7 && ctx.result.arg_count == 0);
+
+    // Options belong to their own table
+    char *argv4[] = {"vcs", "fetch", "--verbose"};
+    assert(parse(set, &ctx, 3, argv4) == -1);
+    assert(ctx.error.code == CLI_ERR_UNKNOWN_OPTION && ctx.error.index == 2);
+    char *argv5[] = {"vcs", "--depth=2", "fetch"};
+    assert(parse(set, &ctx, 3, argv5) == -1);
+    assert(ctx.error.code == CLI_ERR_UNKNOWN_OPTION && ctx.error.index == 1);
+
+    // Errors in the command's part carry argv indexes
+    char *argv6[] = {"vcs", "-C", "x", "commit", "-a"};
+    assert(parse(set, &ctx, 5, argv6) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && strcmp(ctx.error.option, "message") == 0);
+    char *argv7[] = {"vcs", "-v", "fetch", "--depth", "deep"};
+    assert(parse(set, &ctx, 5, argv7) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE && ctx.error.index == 4);
+
+    // Unknown commands are suggested like unknown options
+    char *argv8[] = {"vcs", "comit"};
+    assert(parse(set, &ctx, 2, argv8) == -1);
+    assert(ctx.error.code == CLI_ERR_UNKNOWN_COMMAND && ctx.error.index == 1);
+    assert(strcmp(ctx.error.message, "Unknown command") == 0);
+    assert(strcmp(ctx.error.suggestions[0], "commit") == 0);
+    char *argv9[] = {"vcs", "command-4"};
+    assert(parse(set, &ctx, 2, argv9) == -1 && ctx.error.code == CLI_ERR_UNKNOWN_COMMAND);
+    assert(strcmp(ctx.error.suggestions[0], "command-40") == 0);
+
+    // No command: the global options alone, e.g. for --help
+    char *argv10[] = {"vcs", "--help"};
+    assert(parse(set, &ctx, 2, argv10) == CLI_NO_COMMAND && help);
+    char *argv11[] = {"vcs", "--", "fetch"};
+    assert(parse(set, &ctx, 3, argv11) == 42);
+
+    // Values for the command's table
+    OptionValue values[3];
+    memset(values, 0, sizeof(values));
+    ctx.values = values;
+    char *argv12[] = {"vcs", "fetch", "-f", "--remote", "up"};
+    assert(parse(set, &ctx, 5, argv12) == 42);
+    assert(values[1].i == 1 && strcmp(values[2].s, "up") == 0 && !force && !remote);
+    ctx.values = NULL;
+    cli_ctx_free(&ctx);
+
+    // Usage lists the commands, or one command's options
+    const char *top = capture_usage(set, -1);
+    assert(starts_with(top, "Usage: vcs <command> [options] [arguments]\n\nA version control tool.\n\nOptions:\n"));
+    assert(strstr(top, "\nCommands:\n") != NULL);
+    assert(strstr(top, "\n  commit      Record changes\n") != NULL);
+    assert(strstr(top, "\n  fetch       Download objects and refs\n") != NULL);
+    assert(strstr(top, "\n  command-79\n") != NULL);
+    const char *one = capture_usage(set, 10);
+    assert(starts_with(one, "Usage: vcs commit [options] [arguments]\n\nRecords changes to the repository.\n"));
+    assert(strstr(one, "-m, --message <string>") != NULL && strstr(one, "--verbose") == NULL);
+
+    assert(cli_command_spec(set, COMMAND_COUNT) == NULL);
+    cli_commands_free(set);
+
+    printf("✅ All subcommand tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * SmartArgs Config File Test
+ * Applies an INI file with several sections before argv and checks the
+ * precedence, section selection and error locations.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+static char dir[] = "/tmp/smartargs_config_XXXXXX";
+
+static char *write_file(const char *name, const char *contents) {
+    static char paths[4][256];
+    static int next = 0;
+    char *path = paths[next++ % 4];
+    snprintf(path, sizeof(paths[0]), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fputs(contents, f);
+    fclose(f);
+    return path;
+}
+
+int main() {
+    printf("Running SmartArgs Config File Test...\n");
+    assert(mkdtemp(dir) != NULL);
+
+    // The last line has no newline, so its value ends in the spare byte
+    char *config = write_file("tools.ini",
+        "# shared by several tools\n"
+        "threads = 2\n"
+        "name = \"from config\"\n"
+        "unrelated-key = ignored\n"
+        "\n"
+        "[other-tool]\n"
+        "threads = this would not parse\n"
+        "  [ worker ]\n"
+        "[worker]\r\n"
+        "verbose = yes\r\n"
+        "ratio=0.75\n"
+        "; comment\n"
+        "[late]\n"
+        "threads = 99\n"
+        "[worker]\n"
+        "output = out.txt");
+
+    int verbose = 0, threads = 1;
+    double ratio = 0;
+    const char *name = NULL, *output = NULL;
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(threads, 't', "threads", "Threads"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio"),
+        STRING_REQUIRED(name, 'n', "name", "Name"),
+        STRING(output, 'o', "output", "Output")
+    };
+    OptionSpec *spec = cli_compile(options, 5);
+
+    // The command line overrides the file; required options may come from it
+    char *argv[] = {"worker", "--threads", "8", "in"};
+    ParseContext ctx = {0};
+    ctx.config_path = config;
+    ctx.config_section = "worker";
+    assert(cli_parse_ctx(&ctx, spec, 4, argv) == 0);
+    assert(threads == 8);
+    assert(strcmp(name, "from config") == 0);
+    assert(verbose == 1);
+    assert(ratio == 0.75);
+    assert(strcmp(output, "out.txt") == 0);
+    assert(ctx.result.arg_count == 1);
+    cli_ctx_free(&ctx);
+
+    // Without a section only the top-level keys apply
+    verbose = 0;
+    output = NULL;
+    ctx.config_section = NULL;
+    assert(cli_parse_ctx(&ctx, spec, 1, argv) == 0);
+    assert(threads == 2 && verbose == 0 && output == NULL);
+    cli_ctx_free(&ctx);
+
+    // A missing file is not an error
+    ctx.config_path = "/nonexistent/tools.ini";
+    name = NULL;
+    char *named[] = {"worker", "-n", "x"};
+    assert(cli_parse_ctx(&ctx, spec, 3, named) == 0);
+    cli_ctx_free(&ctx);
+
+    // Errors carry the file and line
+    char *bad_value = write_file("bad_value.ini", "[worker]\nratio = 1.5\n\nthreads = many\n");
+    ctx.config_path = bad_value;
+    ctx.config_section = "worker";
+    assert(cli_parse_ctx(&ctx, spec, 3, named) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE);
+    assert(strcmp(ctx.error.option, "threads") == 0);
+    assert(ctx.error.source == bad_value && ctx.error.line == 4);
+    assert(ctx.error.index == -1);
+    cli_ctx_free(&ctx);
+
+    char *malformed = write_file("malformed.ini", "threads = 3\njust some words\n");
+    ctx.config_path = malformed;
+    assert(cli_parse_ctx(&ctx, spec, 3, named) == -1);
+    assert(ctx.error.code == CLI_ERR_CONFIG_FILE && ctx.error.line == 2);
+    cli_ctx_free(&ctx);
+
+    char *bad_flag = write_file("bad_flag.ini", "verbose = maybe\n");
+    ctx.config_path = bad_flag;
+    assert(cli_parse_ctx(&ctx, spec, 3, named) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE && ctx.error.line == 1);
+    cli_ctx_free(&ctx);
+
+    // Argument errors after a good config report no file
+    ctx.config_path = config;
+    char *bogus[] = {"worker", "--bogus"};
+    assert(cli_parse_ctx(&ctx, spec, 2, bogus) == -1);
+    assert(ctx.error.source == NULL && ctx.error.line == 0 && ctx.error.index == 1);
+    cli_ctx_free(&ctx);
+
+    cli_spec_free(spec);
+    unlink(config);
+    unlink(bad_value);
+    unlink(malformed);
+    unlink(bad_flag);
+    rmdir(dir);
+
+    printf("✅ All config file tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * SmartArgs Context API Test
+ * Parses independent argument vectors from several threads at once and
+ * checks the structured errors reported through ParseContext, including
+ * parsing views of a read-only buffer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define THREAD_COUNT 8
+#define ROUNDS 2000
+
+/* Streaming callback state: records the option value current at each positional */
+typedef struct {
+    const int *threads;
+    int seen;
+    int threads_at[8];
+    int stop_after;
+} StreamState;
+
+static int on_positional(StringView arg, void *userdata) {
+    StreamState *state = userdata;
+    assert(arg.data[0] == 'f');
+    state->threads_at[state->seen++] = *state->threads;
+    return state->seen == state->stop_after;
+}
+
+static void *worker(void *arg) {
+    int id = (int)(size_t)arg;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        char threads_value[16];
+        char name_value[32];
+        snprintf(threads_value, sizeof(threads_value), "%d", id * ROUNDS + round);
+        snprintf(name_value, sizeof(name_value), "worker-%d", id);
+        char *argv[] = {"job", "--threads", threads_value, "--name", name_value, "in", "out"};
+
+        int threads = 0;
+        const char *name = NULL;
+        ParseContext ctx = {0};
+        int ret;
+        TRY_ARGS(ret, &ctx, 7, argv, "Job",
+            INT(threads, 't', "threads", "Threads"),
+            STRING(name, 'n', "name", "Name")
+        );
+
+        assert(ret == 0);
+        assert(threads == id * ROUNDS + round);
+        assert(strcmp(name, name_value) == 0);
+        assert(ctx.result.arg_count == 2);
+        assert(strcmp(ctx.result.args[1], "out") == 0);
+        cli_ctx_free(&ctx);
+    }
+    return NULL;
+}
+
+int main() {
+    printf("Running SmartArgs Context API Test...\n");
+
+    pthread_t workers[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        assert(pthread_create(&workers[i], NULL, worker, (void*)(size_t)i) == 0);
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    printf("✅ %d threads parsed %d vectors each\n", THREAD_COUNT, ROUNDS);
+
+    // Structured errors carry the code, argv index and option
+    int number = 0;
+    int help = 0;
+    char *bad_value[] = {"test", "-v", "--number", "abc"};
+    int verbose = 0;
+    ParseContext ctx = {0};
+    int ret;
+    TRY_CONFIGURE(ret, &ctx, 4, bad_value, "Errors", help,
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(number, 'n', "number", "Number")
+    );
+    assert(ret == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE);
+    assert(ctx.error.index == 3);
+    assert(strcmp(ctx.error.option, "number") == 0);
+    assert(ctx.error.short_name == 'n');
+    assert(strcmp(ctx.error.message, "Invalid integer value") == 0);
+    cli_ctx_free(&ctx);
+
+    char *unknown[] = {"test", "file", "-vq"};
+    TRY_CONFIGURE(ret, &ctx, 3, unknown, "Errors", help,
+        FLAG(verbose, 'v', "verbose", "Verbose")
+    );
+    assert(ret == -1);
+    assert(ctx.error.code == CLI_ERR_UNKNOWN_OPTION);
+    assert(ctx.error.index == 2);
+    assert(ctx.error.short_name == 'q');
+    cli_ctx_free(&ctx);
+
+    const char *input = NULL;
+    char *missing[] = {"test"};
+    TRY_ARGS(ret, &ctx, 1, missing, "Errors",
+        STRING_REQUIRED(input, 'i', "input", "Input")
+    );
+    assert(ret == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING);
+    assert(ctx.error.index == -1);
+    assert(strcmp(ctx.error.option, "input") == 0);
+    cli_ctx_free(&ctx);
+
+    // Streaming positionals see the options given before them
+    int streamed_threads = 0;
+    char *stream_argv[] = {"test", "f0", "--threads", "3", "f1", "-t5", "f2", "--", "f3"};
+    StreamState state = {&streamed_threads, 0, {0}, 0};
+    ctx.on_positional = on_positional;
+    ctx.userdata = &state;
+    TRY_ARGS(ret, &ctx, 9, stream_argv, "Stream",
+        INT(streamed_threads, 't', "threads", "Threads")
+    );
+    assert(ret == 0);
+    assert(state.seen == 4);
+    assert(state.threads_at[0] == 0 && state.threads_at[1] == 3);
+    assert(state.threads_at[2] == 5 && state.threads_at[3] == 5);
+    assert(ctx.result.args == NULL && ctx.result.arg_count == 0);
+    cli_ctx_free(&ctx);
+
+    // The callback can stop the parse; later tokens are not looked at
+    char *stop_argv[] = {"test", "f0", "f1", "--bogus"};
+    state.seen = 0;
+    state.stop_after = 2;
+    TRY_ARGS(ret, &ctx, 4, stop_argv, "Stream",
+        INT(streamed_threads, 't', "threads", "Threads")
+    );
+    assert(ret == 1 && state.seen == 2);
+    cli_ctx_free(&ctx);
+    ctx.on_positional = NULL;
+
+    // Lazy values are read after TRY_ARGS, whose option table is gone by then
+    LazyValue lazy[2];
+    int lazy_threads = 0;
+    char *lazy_argv[] = {"test", "-t", "6", "--ratio=x"};
+    double ratio = 0;
+    ctx.lazy = lazy;
+    TRY_ARGS(ret, &ctx, 4, lazy_argv, "Lazy",
+        INT(lazy_threads, 't', "threads", "Threads"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio")
+    );
+    assert(ret == 0 && lazy_threads == 0);
+    assert(cli_get_int(&ctx, 0, &lazy_threads) == 1 && lazy_threads == 6);
+    assert(cli_get_double(&ctx, 1, &ratio) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE && strcmp(ctx.error.option, "ratio") == 0);
+    assert(cli_get_double(&ctx, 0, &ratio) == -1 && ctx.error.code == CLI_ERR_INVALID_ARGUMENTS);
+    assert(strcmp(ctx.error.option, "threads") == 0);
+    cli_ctx_free(&ctx);
+    ctx.lazy = NULL;
+
+    // Views over read-only memory: any write into the tokens would fault
+    static const char job[] = "job --name=worker-7 --threads 12 -t13 in.txt --name=x";
+    size_t page = 4096;
+    char *mapping = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(mapping != MAP_FAILED);
+    memcpy(mapping, job, sizeof(job) - 1);
+    assert(mprotect(mapping, page, PROT_READ) == 0);
+
+    StringView tokens[16];
+    int token_count = 0;
+    for (const char *c = mapping; *c; ) {
+        const char *end = strchr(c, ' ');
+        size_t len = end ? (size_t)(end - c) : strlen(c);
+        tokens[token_count].data = c;
+        tokens[token_count].length = len;
+        token_count++;
+        c += len + (end ? 1 : 0);
+    }
+
+    int threads = 0;
+    StringView name = {NULL, 0};
+    Option view_options[] = {
+        INT(threads, 't', "threads", "Threads"),
+        STRING_VIEW(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile(view_options, 2);
+    assert(cli_parse_views(&ctx, spec, token_count - 1, tokens) == 0);
+    assert(threads == 13);
+    assert(name.length == 8 && memcmp(name.data, "worker-7", 8) == 0);
+    assert(ctx.result.args == NULL && ctx.result.arg_count == 1);
+    assert(ctx.result.arg_views[0].length == 6 && memcmp(ctx.result.arg_views[0].data, "in.txt", 6) == 0);
+    cli_ctx_free(&ctx);
+
+    // A STRING option cannot be filled from a view
+    const char *text = NULL;
+    Option string_options[] = {STRING(text, 'n', "name", "Name")};
+    OptionSpec *string_spec = cli_compile(string_options, 1);
+    assert(cli_parse_views(&ctx, string_spec, token_count, tokens) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_ARGUMENTS && ctx.error.index == 1);
+    cli_ctx_free(&ctx);
+    cli_spec_free(string_spec);
+    cli_spec_free(spec);
+    munmap(mapping, page);
+
+    printf("✅ All context API tests passed!\n");
+    return 0;
+}
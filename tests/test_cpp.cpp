@@ -0,0 +1,140 @@
+/*
+ * SmartArgs C++ Front-end Test
+ * Parses into typed variables through a constexpr spec, including
+ * string_view, optional and vector values, and checks the errors.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <cassert>
+#include "smartargs.hpp"
+
+namespace sa = smartargs;
+
+constexpr auto cli = sa::make_spec(
+    sa::flag('v', "verbose", "Verbose output"),
+    sa::option<int>('t', "threads", "Worker threads"),
+    sa::option<std::string_view>('n', "name", "Job name").required(),
+    sa::option<std::optional<double>>(0, "ratio", "Sampling ratio"),
+    sa::option<std::vector<int>>('i', "ids", "Ids, comma-separated"),
+    sa::option<std::vector<std::string>>('T', "tag", "Tags"),
+    sa::option<std::uint64_t>(0, "seed", "Random seed"),
+    sa::option<const char *>('o', "output", "Output file"));
+
+static_assert(cli.size == 8, "the spec is a constant");
+
+struct Values {
+    bool verbose = false;
+    int threads = 4;
+    std::string_view name;
+    std::optional<double> ratio;
+    std::vector<int> ids{9, 9};
+    std::vector<std::string> tags;
+    std::uint64_t seed = 0;
+    const char *output = nullptr;
+};
+
+static sa::Result parse(std::vector<const char *> tokens, Values &v) {
+    tokens.insert(tokens.begin(), "job");
+    return cli.parse(int(tokens.size()), const_cast<char *const *>(tokens.data()),
+                     v.verbose, v.threads, v.name, v.ratio, v.ids, v.tags, v.seed, v.output);
+}
+
+int main() {
+    std::printf("Running SmartArgs C++ Front-end Test...\n");
+
+    // Every kind of value, in every syntax of the C parser
+    Values v;
+    sa::Result r = parse({"-vt8", "--name=alpha", "in", "--ratio", "0.25", "-i1,2", "--ids", "0x10",
+                          "-T", "a,b", "--tag=c", "--seed=18446744073709551615", "-oout.txt", "--", "-x"}, v);
+    assert(r && r.code == CLI_OK);
+    assert(v.verbose && v.threads == 8 && v.name == "alpha");
+    assert(v.ratio && *v.ratio == 0.25);
+    assert((v.ids == std::vector<int>{1, 2, 16}));
+    assert((v.tags == std::vector<std::string>{"a,b", "c"}));
+    assert(v.seed == UINT64_MAX);
+    assert(std::strcmp(v.output, "out.txt") == 0);
+    assert(r.args.size() == 2 && r.args[0] == "in" && r.args[1] == "-x");
+
+    // Defaults stay when an option is not given
+    Values defaults;
+    r = parse({"-n", "x"}, defaults);
+    assert(r && !defaults.ratio && defaults.threads == 4 && (defaults.ids == std::vector<int>{9, 9}));
+
+    // Doubles read hex floats, inf and nan like the C library
+    Values f;
+    r = parse({"-n", "x", "--ratio=0x1.8p1"}, f);
+    assert(r && *f.ratio == 3.0);
+    r = parse({"-n", "x", "--ratio", "-0x10"}, f);
+    assert(r && *f.ratio == -16.0);
+    r = parse({"-n", "x", "--ratio=-inf"}, f);
+    assert(r && std::isinf(*f.ratio) && *f.ratio < 0);
+    r = parse({"-n", "x", "--ratio=nan"}, f);
+    assert(r && std::isnan(*f.ratio));
+    r = parse({"-n", "x", "--ratio=0x"}, f);
+    assert(r.code == CLI_ERR_INVALID_VALUE);
+
+    // Errors carry the C codes and messages
+    Values e;
+    r = parse({"--bogus"}, e);
+    assert(r.code == CLI_ERR_UNKNOWN_OPTION && r.index == 1 && r.option.empty());
+    r = parse({"-n", "x", "--threads", "2147483648"}, e);
+    assert(r.code == CLI_ERR_OUT_OF_RANGE && std::strcmp(r.message, "Integer value out of range") == 0);
+    assert(r.index == 4 && r.option == "threads");
+    r = parse({"-n", "x", "--ratio=abc"}, e);
+    assert(r.code == CLI_ERR_INVALID_VALUE && std::strcmp(r.message, "Invalid double value") == 0);
+    r = parse({"-n", "x", "--ratio=1e400"}, e);
+    assert(r.code == CLI_ERR_OUT_OF_RANGE);
+    r = parse({"-n", "x", "--ratio=1e-400"}, e);
+    assert(r.code == CLI_ERR_OUT_OF_RANGE);
+    r = parse({"-n", "x", "-i", "1,,2"}, e);
+    assert(r.code == CLI_ERR_INVALID_VALUE && r.option == "ids");
+    r = parse({"--verbose=1"}, e);
+    assert(r.code == CLI_ERR_UNEXPECTED_VALUE);
+    r = parse({"-n"}, e);
+    assert(r.code == CLI_ERR_MISSING_VALUE && r.option == "name");
+    r = parse({"-v"}, e);
+    assert(r.code == CLI_ERR_REQUIRED_MISSING && r.option == "name" && r.index == -1);
+    r = parse({"-n", "x", "--seed=-1"}, e);
+    assert(r.code == CLI_ERR_OUT_OF_RANGE);
+
+    // A help flag skips the required check, long or short
+    constexpr auto with_help = sa::make_spec(
+        sa::flag('h', "help", "Show help"),
+        sa::option<std::string_view>('n', "name", "Job name").required());
+    bool help = false;
+    std::string_view name;
+    char *help_argv[] = {const_cast<char *>("job"), const_cast<char *>("--help")};
+    r = with_help.parse(2, help_argv, help, name);
+    assert(r && help);
+    help = false;
+    help_argv[1] = const_cast<char *>("-h");
+    r = with_help.parse(2, help_argv, help, name);
+    assert(r && help);
+    r = with_help.parse(1, help_argv, help, name);
+    assert(r.code == CLI_ERR_REQUIRED_MISSING && r.option == "name");
+    constexpr auto short_help = sa::make_spec(
+        sa::flag('h', "hosts", "List hosts"),
+        sa::option<int>('t', "threads", "Threads").required());
+    bool hosts = false;
+    int threads = 0;
+    r = short_help.parse(2, help_argv, hosts, threads);
+    assert(r && hosts);
+
+    // Usage follows the C layout
+    std::string usage = cli.usage("job", "Runs a job.");
+    assert(usage.find("Usage: job [options] [arguments]\n\nRuns a job.\n\nOptions:\n") == 0);
+    assert(usage.find("  -t, --threads <num>") != std::string::npos);
+    assert(usage.find("--ids <num,...>") != std::string::npos);
+    assert(usage.find("Job name (required)") != std::string::npos);
+
+    std::printf("✅ All C++ front-end tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * SmartArgs C++ Spec Validation Test
+ * Only compiled: the plain build must succeed, and the builds defining
+ * DUPLICATE_LONG or DUPLICATE_SHORT must be rejected by the compiler.
+ * The plain build also checks that the C header's macros compile as C++.
+ */
+
+#include "smartargs.hpp"
+
+namespace sa = smartargs;
+
+constexpr auto cli = sa::make_spec(
+    sa::flag('v', "verbose", "Verbose output"),
+#if defined(DUPLICATE_LONG)
+    sa::option<int>('t', "verbose", "Worker threads"));
+#elif defined(DUPLICATE_SHORT)
+    sa::option<int>('v', "threads", "Worker threads"));
+#else
+    sa::option<int>('t', "threads", "Worker threads"));
+#endif
+
+static int try_args(ParseContext *ctx, int argc, char *argv[]) {
+    int threads = 0, help = 0, status;
+    TRY_CONFIGURE(status, ctx, argc, argv, "Runs a job.", help,
+        INT(threads, 't', "threads", "Worker threads")
+    );
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    ParseContext ctx = {};
+    return cli.size == 2 ? try_args(&ctx, argc, argv) : 1;
+}
@@ -0,0 +1,86 @@
+/*
+ * SmartArgs Environment Fallback Test
+ * Reads options from explicit and prefix-derived environment variables and
+ * checks the precedence argv > environment > config file > default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+int main() {
+    printf("Running SmartArgs Environment Fallback Test...\n");
+
+    int threads = 1, dry_run = 0, retries = 3;
+    const char *name = "default";
+    double ratio = 0.5;
+    Option options[] = {
+        INT(threads, 't', "threads", "Threads"),
+        FLAG(dry_run, 'd', "dry-run", "Dry run"),
+        STRING(name, 'n', "name", "Name"),
+        OPTION_ENV(OPT_INT, retries, 'r', "retries", "Retries", "JOB_RETRY_COUNT"),
+        DOUBLE(ratio, 0, "ratio", "Ratio")
+    };
+    OptionSpec *spec = cli_compile(options, 5);
+
+    char config[] = "/tmp/smartargs_env_XXXXXX";
+    int fd = mkstemp(config);
+    assert(fd >= 0);
+    const char contents[] = "threads = 2\nname = config\nratio = 0.25\n";
+    assert(write(fd, contents, sizeof(contents) - 1) == (ssize_t)(sizeof(contents) - 1));
+    close(fd);
+
+    setenv("APP_THREADS", "4", 1);
+    setenv("APP_DRY_RUN", "true", 1);
+    setenv("APP_NAME", "env", 1);
+    setenv("APP_RETRIES", "100", 1);       /* retries only reads JOB_RETRY_COUNT */
+    setenv("JOB_RETRY_COUNT", "7", 1);
+    setenv("APPTHREADS", "9", 1);
+    setenv("APP_UNKNOWN", "x", 1);
+
+    // argv beats the environment, which beats the config file
+    char *argv[] = {"app", "--name", "cli"};
+    ParseContext ctx = {0};
+    ctx.config_path = config;
+    ctx.env_prefix = "APP_";
+    assert(cli_parse_ctx(&ctx, spec, 3, argv) == 0);
+    assert(strcmp(name, "cli") == 0);
+    assert(threads == 4);
+    assert(dry_run == 1);
+    assert(retries == 7);
+    assert(ratio == 0.25);
+    cli_ctx_free(&ctx);
+
+    // Without a prefix only explicit names are read, in every parse mode
+    threads = 1;
+    dry_run = 0;
+    retries = 3;
+    ParseResult result;
+    assert(cli_parse_spec(spec, 1, argv, &result) == 0);
+    assert(threads == 1 && dry_run == 0 && retries == 7);
+    cli_free(&result);
+
+    // Errors name the environment entry
+    setenv("APP_THREADS", "four", 1);
+    assert(cli_parse_ctx(&ctx, spec, 1, argv) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE);
+    assert(strcmp(ctx.error.option, "threads") == 0);
+    assert(strcmp(ctx.error.source, "APP_THREADS=four") == 0);
+    cli_ctx_free(&ctx);
+
+    setenv("APP_THREADS", "4", 1);
+    setenv("APP_DRY_RUN", "perhaps", 1);
+    assert(cli_parse_ctx(&ctx, spec, 1, argv) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE && strcmp(ctx.error.option, "dry-run") == 0);
+    cli_ctx_free(&ctx);
+
+    cli_spec_free(spec);
+    unlink(config);
+
+    printf("✅ All environment fallback tests passed!\n");
+    return 0;
+}
@@ -19,8 +19,8 @@ int test_invalid_integer() {
     int help = 0;
     
     Option options[] = {
-        {"help", 'h', OPT_FLAG, &help, "Help", 0},
-        {"number", 'n', OPT_INT, &number, "Number", 0}
+        FLAG(help, 'h', "help", "Help"),
+        INT(number, 'n', "number", "Number")
     };
     
     ParseResult result;
@@ -44,8 +44,8 @@ int test_invalid_double() {
     int help = 0;
     
     Option options[] = {
-        {"help", 'h', OPT_FLAG, &help, "Help", 0},
-        {"ratio", 'r', OPT_DOUBLE, &ratio, "Ratio", 0}
+        FLAG(help, 'h', "help", "Help"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio")
     };
     
     ParseResult result;
@@ -68,7 +68,7 @@ int test_unknown_option() {
     int help = 0;
     
     Option options[] = {
-        {"help", 'h', OPT_FLAG, &help, "Help", 0}
+        FLAG(help, 'h', "help", "Help")
     };
     
     ParseResult result;
@@ -0,0 +1,130 @@
+/*
+ * SmartArgs Lazy Conversion Test
+ * Parses with ctx.lazy, so only the last value of each option is recorded,
+ * and checks the accessors: conversion on first read, cached results and
+ * errors reported at access time with the original argv index.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+enum { VERBOSE, THREADS, OFFSET, TIMEOUT, SEED, LIMIT, RATIO, NAME, LABEL, IDS, RETRIES, OPTION_COUNT };
+
+int main() {
+    printf("Running SmartArgs Lazy Conversion Test...\n");
+
+    int verbose = 0, threads = 4, retries = 3;
+    int64_t offset = 0, timeout = 0;
+    uint64_t seed = 0;
+    size_t limit = 0;
+    double ratio = 0.5;
+    const char *name = NULL;
+    StringView label = {NULL, 0};
+    IntList ids = {NULL, 0};
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(threads, 't', "threads", "Threads"),
+        INT64(offset, 'o', "offset", "Offset"),
+        DURATION(timeout, 0, "timeout", "Timeout"),
+        UINT64(seed, 0, "seed", "Seed"),
+        SIZE(limit, 'l', "limit", "Limit"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio"),
+        STRING_REQUIRED(name, 'n', "name", "Name"),
+        STRING_VIEW(label, 0, "label", "Label"),
+        INT_LIST(ids, 'i', "ids", "Ids"),
+        OPTION_ENV(OPT_INT, retries, 0, "retries", "Retries", "LAZY_TEST_RETRIES")
+    };
+    OptionSpec *spec = cli_compile(options, OPTION_COUNT);
+    LazyValue lazy[OPTION_COUNT];
+    ParseContext ctx = {0};
+    ctx.lazy = lazy;
+    unsetenv("LAZY_TEST_RETRIES");
+
+    // Only the last value is kept, so earlier bad ones never matter; lists accumulate
+    char *argv[] = {"app", "-t", "junk", "--threads=16", "-v", "-o", "-5", "--timeout=1m", "--seed=42",
+                    "-l", "4k", "-n", "job", "--label", "east", "-i1,2", "--ids=3", "file"};
+    assert(cli_parse_ctx(&ctx, spec, 18, argv) == 0);
+    assert(threads == 4 && name == NULL && verbose == 0);   /* variables are untouched */
+    assert(ctx.result.arg_count == 1);
+    assert(lazy[THREADS].raw.length == 2 && lazy[THREADS].index == 3);
+
+    int i = 0;
+    int64_t i64 = 0;
+    uint64_t u64 = 0;
+    size_t size = 0;
+    double d = -1;
+    const char *s = NULL;
+    StringView view = {NULL, 0};
+    assert(cli_get_int(&ctx, THREADS, &i) == 1 && i == 16);
+    assert(cli_get_flag(&ctx, VERBOSE, &i) == 1 && i == 1);
+    assert(cli_get_int64(&ctx, OFFSET, &i64) == 1 && i64 == -5);
+    assert(cli_get_int64(&ctx, TIMEOUT, &i64) == 1 && i64 == 60000000000LL);
+    assert(cli_get_uint64(&ctx, SEED, &u64) == 1 && u64 == 42);
+    assert(cli_get_size(&ctx, LIMIT, &size) == 1 && size == 4096);
+    assert(cli_get_string(&ctx, NAME, &s) == 1 && s == argv[12]);
+    assert(cli_get_view(&ctx, LABEL, &view) == 1 && view.length == 4 && view.data == argv[14]);
+    OptionValue value;
+    assert(cli_get_value(&ctx, IDS, &value) == 1 && value.ints.count == 3 && value.ints.items[2] == 3);
+
+    // Options not given leave the value alone
+    assert(cli_get_double(&ctx, RATIO, &d) == 0 && d == -1);
+    assert(cli_get_int(&ctx, RETRIES, &i) == 0);
+
+    // Reading as another type is an error
+    assert(cli_get_int(&ctx, OFFSET, &i) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_ARGUMENTS && strcmp(ctx.error.option, "offset") == 0);
+    cli_ctx_free(&ctx);
+
+    // Bad values parse, and fail when read, with the index of the token
+    char *bad_argv[] = {"app", "-n", "x", "--ratio", "abc", "-t", "99999999999", "-t2"};
+    assert(cli_parse_ctx(&ctx, spec, 5, bad_argv) == 0);
+    assert(cli_get_double(&ctx, RATIO, &d) == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_VALUE && ctx.error.index == 4);
+    assert(strcmp(ctx.error.message, "Invalid double value") == 0 && strcmp(ctx.error.option, "ratio") == 0);
+    assert(cli_get_double(&ctx, RATIO, &d) == -1 && ctx.error.index == 4);
+    cli_ctx_free(&ctx);
+    assert(cli_parse_ctx(&ctx, spec, 8, bad_argv) == 0);
+    assert(cli_get_int(&ctx, THREADS, &i) == 1 && i == 2);
+    cli_ctx_free(&ctx);
+    assert(cli_parse_ctx(&ctx, spec, 7, bad_argv) == 0);
+    assert(cli_get_int(&ctx, THREADS, &i) == -1);
+    assert(ctx.error.code == CLI_ERR_OUT_OF_RANGE && ctx.error.index == 6);
+    cli_ctx_free(&ctx);
+
+    // Missing values and required options are still parse errors
+    char *missing_argv[] = {"app", "-n", "x", "--threads"};
+    assert(cli_parse_ctx(&ctx, spec, 4, missing_argv) == -1);
+    assert(ctx.error.code == CLI_ERR_MISSING_VALUE && ctx.error.index == 3);
+    assert(cli_parse_ctx(&ctx, spec, 1, missing_argv) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && strcmp(ctx.error.option, "name") == 0);
+
+    // Environment values report their source instead of an index
+    setenv("LAZY_TEST_RETRIES", "many", 1);
+    assert(cli_parse_ctx(&ctx, spec, 3, missing_argv) == 0);
+    assert(cli_get_int(&ctx, RETRIES, &i) == -1);
+    assert(ctx.error.index == -1 && strcmp(ctx.error.source, "LAZY_TEST_RETRIES=many") == 0);
+    cli_ctx_free(&ctx);
+    unsetenv("LAZY_TEST_RETRIES");
+
+    // Views are converted from their slices, without reading past them
+    StringView tokens[] = {{"app", 3}, {"-n", 2}, {"x", 1}, {"--ratio=0.25xyz", 12}, {"--label=westeast", 12}};
+    assert(cli_parse_views(&ctx, spec, 5, tokens) == -1);   /* STRING needs views */
+    assert(ctx.error.code == CLI_ERR_INVALID_ARGUMENTS);
+    cli_ctx_free(&ctx);
+    cli_spec_free(spec);
+    options[NAME].required = 0;   /* read when the table is compiled */
+    spec = cli_compile(options, OPTION_COUNT);
+    StringView view_tokens[] = {{"app", 3}, {"--ratio=0.25xyz", 12}, {"--label=westeast", 12}};
+    assert(cli_parse_views(&ctx, spec, 3, view_tokens) == 0);
+    assert(cli_get_double(&ctx, RATIO, &d) == 1 && d == 0.25);
+    assert(cli_get_view(&ctx, LABEL, &view) == 1 && view.length == 4 && memcmp(view.data, "west", 4) == 0);
+    cli_ctx_free(&ctx);
+
+    cli_spec_free(spec);
+    printf("✅ All lazy conversion tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * SmartArgs List Options Test
+ * Parses repeated and comma-separated list options into contiguous arrays,
+ * including one very long id list, and checks their errors and lifetimes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define ID_COUNT 100000
+
+int main() {
+    printf("Running SmartArgs List Options Test...\n");
+
+    static int default_ids[] = {7, 8};
+    IntList ids = {default_ids, 2};
+    DoubleList weights = {NULL, 0};
+    StringList tags = {NULL, 0};
+    Option options[] = {
+        INT_LIST(ids, 'i', "ids", "Ids"),
+        DOUBLE_LIST(weights, 'w', "weights", "Weights"),
+        STRING_LIST(tags, 't', "tag", "Tags")
+    };
+    OptionSpec *spec = cli_compile(options, 3);
+
+    // Defaults stay until the option is given
+    char *none[] = {"job"};
+    ParseContext ctx = {0};
+    assert(cli_parse_ctx(&ctx, spec, 1, none) == 0);
+    assert(ids.items == default_ids && ids.count == 2);
+    cli_ctx_free(&ctx);
+
+    // The first occurrence replaces the default, later ones append
+    char *argv[] = {"job", "--ids=1,2,3", "-t", "a,b", "-i", "-4", "--weights", "0.5,1e3,-2",
+                    "--tag=c", "in", "-i0x10,0b11"};
+    assert(cli_parse_ctx(&ctx, spec, 11, argv) == 0);
+    int expected_ids[] = {1, 2, 3, -4, 16, 3};
+    assert(ids.count == 6 && memcmp(ids.items, expected_ids, sizeof(expected_ids)) == 0);
+    assert(weights.count == 3);
+    assert(weights.items[0] == 0.5 && weights.items[1] == 1000.0 && weights.items[2] == -2.0);
+    assert(tags.count == 2 && tags.items[0] == argv[3] && tags.items[1] == argv[8] + 6);
+    assert(ctx.result.arg_count == 1);
+    cli_ctx_free(&ctx);
+
+    // A long list lands in one contiguous buffer; ids straddle the 8-byte chunks
+    size_t size = (size_t)ID_COUNT * 12 + 16;
+    char *text = malloc(size);
+    size_t len = (size_t)snprintf(text, size, "--ids=");
+    for (int i = 0; i < ID_COUNT; i++) {
+        len += (size_t)snprintf(text + len, size - len, i ? ",%d" : "%d", i * 37 - 5000);
+    }
+    char *long_argv[] = {"job", text, "--ids", "1"};
+    assert(cli_parse_ctx(&ctx, spec, 4, long_argv) == 0);
+    assert(ids.count == ID_COUNT + 1);
+    for (int i = 0; i < ID_COUNT; i++) {
+        assert(ids.items[i] == i * 37 - 5000);
+    }
+    assert(ids.items[ID_COUNT] == 1);
+    cli_ctx_free(&ctx);
+    free(text);
+
+    // Every element is checked; empty elements are invalid
+    char *bad[][2] = {
+        {"job", "--ids=1,,2"}, {"job", "--ids=1,"}, {"job", "--ids="}, {"job", "--ids=1,x"},
+        {"job", "--weights=1.5,abc"}
+    };
+    for (int i = 0; i < 5; i++) {
+        assert(cli_parse_ctx(&ctx, spec, 2, bad[i]) == -1);
+        assert(ctx.error.code == CLI_ERR_INVALID_VALUE && ctx.error.index == 1);
+        cli_ctx_free(&ctx);
+    }
+    char *range[] = {"job", "--ids=1,2147483648"};
+    assert(cli_parse_ctx(&ctx, spec, 2, range) == -1);
+    assert(ctx.error.code == CLI_ERR_OUT_OF_RANGE && strcmp(ctx.error.message, "Integer value out of range") == 0);
+    cli_ctx_free(&ctx);
+    char *missing[] = {"job", "--weights"};
+    assert(cli_parse_ctx(&ctx, spec, 2, missing) == -1);
+    assert(ctx.error.code == CLI_ERR_MISSING_VALUE);
+    cli_ctx_free(&ctx);
+
+    // Values in a context; a required list needs at least one item
+    OptionValue values[3];
+    memset(values, 0, sizeof(values));
+    Option required[] = {INT_LIST_REQUIRED(ids, 'i', "ids", "Ids")};
+    OptionSpec *required_spec = cli_compile(required, 1);
+    ParseContext vctx = {0};
+    vctx.values = values;
+    assert(cli_parse_ctx(&vctx, required_spec, 1, none) == -1);
+    assert(vctx.error.code == CLI_ERR_REQUIRED_MISSING);
+    cli_ctx_free(&vctx);
+    char *given[] = {"job", "-i", "5,6"};
+    assert(cli_parse_ctx(&vctx, required_spec, 3, given) == 0);
+    assert(values[0].ints.count == 2 && values[0].ints.items[1] == 6);
+    cli_ctx_free(&vctx);
+    cli_spec_free(required_spec);
+
+    // Views: numeric lists parse, string lists would need argv
+    StringView views[] = {{"job", 3}, {"-w1.25,2.5xyz", 10}, {"-tname", 6}};
+    vctx.values = values;
+    memset(values, 0, sizeof(values));
+    assert(cli_parse_views(&vctx, spec, 2, views) == 0);
+    assert(values[1].doubles.count == 2 && values[1].doubles.items[1] == 2.5);
+    cli_ctx_free(&vctx);
+    assert(cli_parse_views(&vctx, spec, 3, views) == -1);
+    assert(vctx.error.code == CLI_ERR_INVALID_ARGUMENTS);
+    cli_ctx_free(&vctx);
+
+    cli_spec_free(spec);
+
+    // Items from the environment are replaced by argv, not appended to
+    IntList ports = {NULL, 0};
+    Option env_options[] = {OPTION_ENV(OPT_INT_LIST, ports, 'p', "port", "Ports", "SMARTARGS_TEST_PORTS")};
+    OptionSpec *env_spec = cli_compile(env_options, 1);
+    setenv("SMARTARGS_TEST_PORTS", "80,443", 1);
+    assert(cli_parse_ctx(&ctx, env_spec, 1, none) == 0);
+    assert(ports.count == 2 && ports.items[1] == 443);
+    cli_ctx_free(&ctx);
+    char *ports_argv[] = {"job", "-p", "8080", "-p9090"};
+    assert(cli_parse_ctx(&ctx, env_spec, 4, ports_argv) == 0);
+    assert(ports.count == 2 && ports.items[0] == 8080 && ports.items[1] == 9090);
+    cli_ctx_free(&ctx);
+    unsetenv("SMARTARGS_TEST_PORTS");
+    cli_spec_free(env_spec);
+
+    // CONFIGURE keeps the list arrays in its result until CLEANUP()
+    int help = 0;
+    IntList configured = {NULL, 0};
+    StringList names = {NULL, 0};
+    char *configure_argv[] = {"job", "-i1,2,3", "-n", "a", "--name=b", "in"};
+    CONFIGURE(6, configure_argv, "Lists", help,
+              INT_LIST(configured, 'i', "ids", "Ids"),
+              STRING_LIST(names, 'n', "name", "Names"));
+    assert(configured.count == 3 && names.count == 2 && arg_count == 1);
+    assert(smartargs_result.resources != NULL && smartargs_result.args == args);
+    CLEANUP();
+    assert(smartargs_result.resources == NULL && args == NULL && arg_count == 0);
+
+    printf("✅ All list option tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * SmartArgs Numeric Parsing Test
+ * Covers integer bases and ranges, 64-bit types, size suffixes, durations
+ * and exact round-tripping of doubles in a non-C locale.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <locale.h>
+#include <float.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+static int number;
+static int64_t wide;
+static uint64_t unsigned_wide;
+static size_t size;
+static int64_t duration;
+static double real;
+
+static Option options[] = {
+    INT(number, 'n', "number", "Number"),
+    INT64(wide, 'w', "wide", "Wide"),
+    UINT64(unsigned_wide, 'u', "unsigned", "Unsigned"),
+    SIZE(size, 's', "size", "Size"),
+    DURATION(duration, 'd', "duration", "Duration"),
+    DOUBLE(real, 'r', "real", "Real")
+};
+
+/* Parses one --name=value pair and returns the error code */
+static CliErrorCode parse_one(const char *name, const char *value) {
+    char token[128];
+    snprintf(token, sizeof(token), "--%s=%s", name, value);
+    char *argv[] = {"test", token};
+    ParseContext ctx = {0};
+    OptionSpec *spec = cli_compile(options, sizeof(options) / sizeof(options[0]));
+    cli_parse_ctx(&ctx, spec, 2, argv);
+    CliErrorCode code = ctx.error.code;
+    cli_ctx_free(&ctx);
+    cli_spec_free(spec);
+    return code;
+}
+
+int main() {
+    printf("Running SmartArgs Numeric Parsing Test...\n");
+
+    // Integers: bases, signs and the int range
+    assert(parse_one("number", "123456789") == CLI_OK && number == 123456789);
+    assert(parse_one("number", "-2147483648") == CLI_OK && number == INT32_MIN);
+    assert(parse_one("number", "0x7fffffff") == CLI_OK && number == INT32_MAX);
+    assert(parse_one("number", "0b101") == CLI_OK && number == 5);
+    assert(parse_one("number", "0o17") == CLI_OK && number == 15);
+    assert(parse_one("number", "+42") == CLI_OK && number == 42);
+    assert(parse_one("number", "2147483648") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("number", "") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("number", "12a") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("number", "0x") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("number", " 1") == CLI_ERR_INVALID_VALUE);
+
+    // 64-bit types, including the bounds and one past them
+    assert(parse_one("wide", "9223372036854775807") == CLI_OK && wide == INT64_MAX);
+    assert(parse_one("wide", "-9223372036854775808") == CLI_OK && wide == INT64_MIN);
+    assert(parse_one("wide", "9223372036854775808") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("wide", "12345678901234567") == CLI_OK && wide == 12345678901234567LL);
+    assert(parse_one("unsigned", "18446744073709551615") == CLI_OK && unsigned_wide == UINT64_MAX);
+    assert(parse_one("unsigned", "18446744073709551616") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("unsigned", "99999999999999999999") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("unsigned", "0xFFFFFFFFFFFFFFFF") == CLI_OK && unsigned_wide == UINT64_MAX);
+    assert(parse_one("unsigned", "-1") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("unsigned", "-0") == CLI_OK && unsigned_wide == 0);
+
+    // Sizes use binary multiples
+    assert(parse_one("size", "512") == CLI_OK && size == 512);
+    assert(parse_one("size", "64k") == CLI_OK && size == 64 * 1024);
+    assert(parse_one("size", "512M") == CLI_OK && size == 512u * 1024 * 1024);
+    assert(parse_one("size", "2GiB") == CLI_OK && size == (size_t)2 << 30);
+    assert(parse_one("size", "1TB") == CLI_OK && size == (size_t)1 << 40);
+    assert(parse_one("size", "10B") == CLI_OK && size == 10);
+    assert(parse_one("size", "0x1B") == CLI_OK && size == 27);
+    assert(parse_one("size", "16E") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("size", "1Q") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("size", "1Mi") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("size", "M") == CLI_ERR_INVALID_VALUE);
+
+    // Durations in nanoseconds; a bare number means seconds
+    assert(parse_one("duration", "250ms") == CLI_OK && duration == 250000000LL);
+    assert(parse_one("duration", "1.5s") == CLI_OK && duration == 1500000000LL);
+    assert(parse_one("duration", "1h30m") == CLI_OK && duration == 5400000000000LL);
+    assert(parse_one("duration", "90") == CLI_OK && duration == 90000000000LL);
+    assert(parse_one("duration", "2d") == CLI_OK && duration == 172800000000000LL);
+    assert(parse_one("duration", "10us") == CLI_OK && duration == 10000);
+    assert(parse_one("duration", "-1m") == CLI_OK && duration == -60000000000LL);
+    assert(parse_one("duration", "0.001ns") == CLI_OK && duration == 0);
+    assert(parse_one("duration", "1m30") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("duration", "5x") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("duration", ".s") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("duration", "3000000h") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("duration", "106751d") == CLI_OK && duration == 106751LL * 86400000000000LL);
+    assert(parse_one("duration", "106752d") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("duration", "213503.99999d") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("duration", "106751d23h47m16.854775808s") == CLI_ERR_OUT_OF_RANGE);
+
+    // Doubles ignore the process locale, even one with a decimal comma
+    if (!setlocale(LC_NUMERIC, "de_DE.UTF-8")) {
+        setlocale(LC_NUMERIC, "fr_FR.UTF-8");
+    }
+    assert(parse_one("real", "0.1") == CLI_OK && real == 0.1);
+    assert(parse_one("real", "-2.5e3") == CLI_OK && real == -2500.0);
+    assert(parse_one("real", "3") == CLI_OK && real == 3.0);
+    assert(parse_one("real", "1e308") == CLI_OK && real == 1e308);
+    assert(parse_one("real", "2.2250738585072014e-308") == CLI_OK && real == 2.2250738585072014e-308);
+    assert(parse_one("real", "1e400") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("real", "1e-400") == CLI_ERR_OUT_OF_RANGE);
+    assert(parse_one("real", "4.9e-324") == CLI_ERR_OUT_OF_RANGE);   /* subnormal */
+    assert(parse_one("real", "1,5") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one("real", "") == CLI_ERR_INVALID_VALUE);
+
+    // Every printed double reads back to the same bits
+    srand(7);
+    for (int i = 0; i < 20000; i++) {
+        uint64_t bits = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+        double expected;
+        memcpy(&expected, &bits, sizeof(expected));
+        if (expected != expected || expected - expected != 0 ||
+            (expected < DBL_MIN && expected > -DBL_MIN)) {
+            continue;  /* skip NaN, infinities, and subnormals, which are range errors */
+        }
+        char text[64];
+        snprintf(text, sizeof(text), "%.17g", expected);
+        for (char *c = text; *c; c++) {
+            if (*c == ',') *c = '.';  /* printf follows the locale */
+        }
+        assert(parse_one("real", text) == CLI_OK);
+        assert(memcmp(&real, &expected, sizeof(real)) == 0);
+    }
+    setlocale(LC_NUMERIC, "C");
+
+    // Short doubles take the exact fast path; compare against strtod
+    for (int i = 0; i < 20000; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "%d.%03de%d", rand() % 100000, rand() % 1000, rand() % 40 - 20);
+        assert(parse_one("real", text) == CLI_OK);
+        double expected = strtod(text, NULL);
+        assert(memcmp(&real, &expected, sizeof(real)) == 0);
+    }
+
+    printf("✅ All numeric parsing tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * SmartArgs Abbreviation Test
+ * Covers unique-prefix matching of long names, ambiguous prefixes and the
+ * suggestions reported for unknown names, on a small and a large table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define LARGE_COUNT 5000
+
+static int verbose, verbose_log, version, threads;
+static Option options[] = {
+    FLAG(verbose, 'v', "verbose", "Verbose"),
+    FLAG(verbose_log, 0, "verbose-log", "Log verbosely"),
+    FLAG(version, 'V', "version", "Version"),
+    INT(threads, 't', "threads", "Threads")
+};
+
+/* Parses argv[1] alone and returns the error code */
+static CliErrorCode parse_one(const OptionSpec *spec, const char *token, ParseContext *ctx) {
+    char *argv[] = {"tool", (char*)token};
+    cli_parse_ctx(ctx, spec, 2, argv);
+    CliErrorCode code = ctx->error.code;
+    cli_ctx_free(ctx);
+    return code;
+}
+
+int main() {
+    printf("Running SmartArgs Abbreviation Test...\n");
+    OptionSpec *exact = cli_compile(options, 4);
+    OptionSpec *prefix = cli_compile_ex(options, 4, CLI_PREFIX_MATCH);
+    ParseContext ctx = {0};
+
+    // Abbreviations only match with CLI_PREFIX_MATCH
+    assert(parse_one(exact, "--thr=3", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "threads") == 0 && ctx.error.suggestions[1] == NULL);
+    assert(parse_one(prefix, "--thr=3", &ctx) == CLI_OK && threads == 3);
+    assert(parse_one(prefix, "--verbose-", &ctx) == CLI_OK && verbose_log == 1);
+    assert(parse_one(prefix, "--verbose", &ctx) == CLI_OK && verbose == 1);
+    assert(parse_one(prefix, "--vers", &ctx) == CLI_OK && version == 1);
+
+    // Ambiguous prefixes list the names they match, shortest first
+    assert(parse_one(prefix, "--verb", &ctx) == CLI_ERR_AMBIGUOUS_OPTION);
+    assert(strcmp(ctx.error.message, "Ambiguous option") == 0 && ctx.error.index == 1);
+    assert(strcmp(ctx.error.suggestions[0], "verbose") == 0);
+    assert(strcmp(ctx.error.suggestions[1], "verbose-log") == 0);
+    assert(ctx.error.suggestions[2] == NULL);
+    assert(parse_one(prefix, "--ver", &ctx) == CLI_ERR_AMBIGUOUS_OPTION);
+    assert(ctx.error.suggestions[2] != NULL && strcmp(ctx.error.suggestions[2], "version") == 0);
+
+    // Misspellings get the names within a small edit distance
+    assert(parse_one(prefix, "--thread=1", &ctx) == CLI_OK);
+    assert(parse_one(exact, "--thread", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "threads") == 0);
+    assert(parse_one(prefix, "--vrebose", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "verbose") == 0);
+    assert(parse_one(prefix, "--treads=2", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "threads") == 0);
+    assert(parse_one(prefix, "--colour", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(ctx.error.suggestions[0] == NULL);
+
+    cli_spec_free(exact);
+    cli_spec_free(prefix);
+
+    // A large table: names share long prefixes and differ near the end
+    static Option large[LARGE_COUNT];
+    static char names[LARGE_COUNT][32];
+    static int values[LARGE_COUNT];
+    for (int i = 0; i < LARGE_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "feature-%04d-enabled", i);
+        Option opt = FLAG(values[i], 0, names[i], NULL);
+        large[i] = opt;
+    }
+    OptionSpec *spec = cli_compile_ex(large, LARGE_COUNT, CLI_PREFIX_MATCH);
+    assert(parse_one(spec, "--feature-1234", &ctx) == CLI_OK && values[1234] == 1);
+    assert(parse_one(spec, "--feature-12", &ctx) == CLI_ERR_AMBIGUOUS_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "feature-1200-enabled") == 0);
+    assert(parse_one(spec, "--feature-4321-enabeld", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "feature-4321-enabled") == 0);
+    assert(parse_one(spec, "--feature-4321-enable-", &ctx) == CLI_ERR_UNKNOWN_OPTION);
+    assert(strcmp(ctx.error.suggestions[0], "feature-4321-enabled") == 0);
+    cli_spec_free(spec);
+
+    printf("✅ All abbreviation tests passed!\n");
+    return 0;
+}
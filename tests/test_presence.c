@@ -0,0 +1,111 @@
+/*
+ * SmartArgs Presence Test
+ * Required options are checked against what was given, not against the
+ * values of their variables; ctx.counts reports occurrences per option
+ * and COUNT options add one per occurrence, e.g. -vvv.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define MANY_OPTIONS 600
+
+enum { VERBOSE, QUIET, THREADS, RATIO, NAME, TAGS, OPTION_COUNT };
+
+int main() {
+    printf("Running SmartArgs Presence Test...\n");
+
+    int verbose = 0, quiet = 0, threads = 4;
+    double ratio = 0.5;
+    const char *name = "default";
+    StringList tags = {NULL, 0};
+    Option options[] = {
+        COUNT(verbose, 'v', "verbose", "More output, repeat for more"),
+        FLAG(quiet, 'q', "quiet", "Quiet"),
+        INT_REQUIRED(threads, 't', "threads", "Threads"),
+        DOUBLE_REQUIRED(ratio, 'r', "ratio", "Ratio"),
+        STRING(name, 'n', "name", "Name"),
+        STRING_LIST(tags, 0, "tag", "Tags")
+    };
+    OptionSpec *spec = cli_compile(options, OPTION_COUNT);
+    unsigned counts[OPTION_COUNT];
+    ParseContext ctx = {0};
+    ctx.counts = counts;
+
+    // Numeric required options are missing despite their defaults
+    char *argv1[] = {"app", "-r", "1"};
+    assert(cli_parse_ctx(&ctx, spec, 3, argv1) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && strcmp(ctx.error.option, "threads") == 0);
+    char *argv2[] = {"app", "--threads=4"};
+    assert(cli_parse_ctx(&ctx, spec, 2, argv2) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && strcmp(ctx.error.option, "ratio") == 0);
+
+    // Counts per option, and -vvv adds three
+    char *argv3[] = {"app", "-vvv", "-t", "8", "--verbose", "-r0.25", "-t9", "--tag", "a", "--tag=b"};
+    assert(cli_parse_ctx(&ctx, spec, 10, argv3) == 0);
+    assert(verbose == 4 && threads == 9 && ratio == 0.25 && tags.count == 2);
+    assert(counts[VERBOSE] == 4 && counts[THREADS] == 2 && counts[RATIO] == 1 && counts[TAGS] == 2);
+    assert(counts[QUIET] == 0 && counts[NAME] == 0 && strcmp(name, "default") == 0);
+    cli_ctx_free(&ctx);
+
+    // Counts take no value on the command line
+    char *argv4[] = {"app", "--verbose=2"};
+    assert(cli_parse_ctx(&ctx, spec, 2, argv4) == -1);
+    assert(ctx.error.code == CLI_ERR_UNEXPECTED_VALUE);
+
+    // A config file sets the level, argv adds to it
+    char config[] = "/tmp/smartargs_presence_XXXXXX";
+    int fd = mkstemp(config);
+    assert(fd >= 0);
+    const char contents[] = "verbose = 2\nthreads = 2\nratio = 1\n";
+    assert(write(fd, contents, sizeof(contents) - 1) == (ssize_t)(sizeof(contents) - 1));
+    close(fd);
+    ctx.config_path = config;
+    verbose = 0;
+    char *argv5[] = {"app", "-v"};
+    assert(cli_parse_ctx(&ctx, spec, 2, argv5) == 0);
+    assert(verbose == 3 && threads == 2 && counts[VERBOSE] == 2 && counts[THREADS] == 1);
+    cli_ctx_free(&ctx);
+    ctx.config_path = NULL;
+    unlink(config);
+
+    // Lazy parses read counts through cli_get_int()
+    LazyValue lazy[OPTION_COUNT];
+    ctx.lazy = lazy;
+    char *argv6[] = {"app", "-vv", "-t", "1", "-r", "2"};
+    assert(cli_parse_ctx(&ctx, spec, 6, argv6) == 0);
+    int level = 0;
+    assert(cli_get_int(&ctx, VERBOSE, &level) == 1 && level == 2);
+    assert(cli_get_flag(&ctx, VERBOSE, &level) == -1);   /* a count is not a flag */
+    cli_ctx_free(&ctx);
+    assert(cli_parse_ctx(&ctx, spec, 1, argv6) == -1 && ctx.error.code == CLI_ERR_REQUIRED_MISSING);
+    ctx.lazy = NULL;
+    cli_spec_free(spec);
+
+    // Past 512 options the bitset moves to the heap
+    static Option many[MANY_OPTIONS];
+    static int values[MANY_OPTIONS];
+    static char names[MANY_OPTIONS][8];
+    for (int i = 0; i < MANY_OPTIONS; i++) {
+        snprintf(names[i], sizeof(names[i]), "o%d", i);
+        Option o = {.long_name = names[i], .type = OPT_INT, .value = &values[i], .required = i % 100 == 99};
+        many[i] = o;
+    }
+    spec = cli_compile(many, MANY_OPTIONS);
+    char *argv7[] = {"app", "--o99=1", "--o199=1", "--o299=1", "--o399=1", "--o499=1", "--o599=1"};
+    ctx.counts = NULL;
+    assert(cli_parse_ctx(&ctx, spec, 7, argv7) == 0);
+    cli_ctx_free(&ctx);
+    assert(cli_parse_ctx(&ctx, spec, 6, argv7) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && strcmp(ctx.error.option, "o599") == 0);
+    cli_ctx_free(&ctx);
+    cli_spec_free(spec);
+
+    printf("✅ All presence tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * SmartArgs Response File Test
+ * Expands nested @files with quoting and escapes, and checks the depth limit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+static char dir[] = "/tmp/smartargs_response_XXXXXX";
+
+static char *write_file(const char *name, const char *contents) {
+    static char paths[4][256];
+    static int next = 0;
+    char *path = paths[next++ % 4];
+    snprintf(path, sizeof(paths[0]), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fputs(contents, f);
+    fclose(f);
+    return path;
+}
+
+int main() {
+    printf("Running SmartArgs Response File Test...\n");
+    assert(mkdtemp(dir) != NULL);
+
+    // The inner file ends without a newline, so its last token uses the spare byte
+    char inner_token[300];
+    char *inner = write_file("inner.rsp", "--threads=12 'quoted file' escaped\\ space");
+    snprintf(inner_token, sizeof(inner_token), "@%s", inner);
+
+    char outer_contents[400];
+    snprintf(outer_contents, sizeof(outer_contents), "--name \"two words\"\n\t@%s\nlast", inner);
+    char outer_token[300];
+    char *outer = write_file("outer.rsp", outer_contents);
+    snprintf(outer_token, sizeof(outer_token), "@%s", outer);
+
+    int threads = 0;
+    const char *name = NULL;
+    Option options[] = {
+        INT(threads, 't', "threads", "Threads"),
+        STRING(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile_ex(options, 2, CLI_RESPONSE_FILES);
+    assert(spec != NULL);
+
+    char *argv[] = {"test", "first", outer_token, "@/nonexistent/file", "--", "@literal"};
+    ParseResult result;
+    assert(cli_parse_spec(spec, 6, argv, &result) == 0);
+    assert(threads == 12);
+    assert(strcmp(name, "two words") == 0);
+    assert(result.arg_count == 6);
+    assert(strcmp(result.args[0], "first") == 0);
+    assert(strcmp(result.args[1], "quoted file") == 0);
+    assert(strcmp(result.args[2], "escaped space") == 0);
+    assert(strcmp(result.args[3], "last") == 0);
+    assert(strcmp(result.args[4], "@/nonexistent/file") == 0);
+    assert(strcmp(result.args[5], "@literal") == 0);
+
+    // The files on disk are untouched by the in-place tokenizer
+    FILE *f = fopen(inner, "r");
+    char check[64] = {0};
+    assert(fread(check, 1, sizeof(check) - 1, f) > 0);
+    fclose(f);
+    assert(strcmp(check, "--threads=12 'quoted file' escaped\\ space") == 0);
+    cli_free(&result);
+
+    // A file that includes itself hits the depth limit
+    char loop_contents[300];
+    char loop_token[300];
+    snprintf(loop_contents, sizeof(loop_contents), "x @%s/loop.rsp", dir);
+    char *loop = write_file("loop.rsp", loop_contents);
+    snprintf(loop_token, sizeof(loop_token), "@%s", loop);
+    char *loop_argv[] = {"test", loop_token};
+    ParseContext ctx = {0};
+    assert(cli_parse_ctx(&ctx, spec, 2, loop_argv) == -1);
+    assert(ctx.error.code == CLI_ERR_RESPONSE_FILE);
+    assert(ctx.error.index == 1);
+    cli_ctx_free(&ctx);
+
+    // Without CLI_RESPONSE_FILES an @file is an ordinary positional
+    OptionSpec *plain = cli_compile(options, 2);
+    assert(cli_parse_spec(plain, 6, argv, &result) == 0);
+    assert(result.arg_count == 4 && strcmp(result.args[1], outer_token) == 0);
+    cli_free(&result);
+
+    cli_spec_free(plain);
+    cli_spec_free(spec);
+    unlink(inner);
+    unlink(outer);
+    unlink(loop);
+    rmdir(dir);
+
+    printf("✅ All response file tests passed!\n");
+    return 0;
+}
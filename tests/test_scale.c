@@ -0,0 +1,313 @@
+/*
+ * SmartArgs Scalability Test
+ * Built with its own copy of the library compiled with SMARTARGS_STATS;
+ * feeds pathological inputs (a million positionals, ten thousand options,
+ * 64KB names, response file bombs, malformed '=' tokens) and checks that
+ * lookups and allocations grow linearly and time at most about linearly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define MANY_POSITIONALS 1000000
+#define MANY_OPTIONS 10000
+#define LONG_NAME 65536
+#define FAN_LEVELS 12
+
+/* Eight times the input may take at most this many times as long (quadratic: 64) */
+#define MAX_TIME_RATIO 24.0
+
+static char dir[] = "/tmp/smartargs_scale_XXXXXX";
+
+static double cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Best of three runs of parse(n), so one descheduled run does not fail the test */
+static double best_time(void (*parse)(int), int n) {
+    double best = 0;
+    for (int run = 0; run < 3; run++) {
+        double start = cpu_seconds();
+        parse(n);
+        double elapsed = cpu_seconds() - start;
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void check_linear(const char *what, void (*parse)(int), int n) {
+    double small = best_time(parse, n / 8);
+    double large = best_time(parse, n);
+    printf("  %-22s %8d: %.4fs, %8d: %.4fs\n", what, n / 8, small, n, large);
+    /* Below a millisecond the clock and the cache say more than the parser */
+    assert(large < 0.001 || large / (small > 1e-6 ? small : 1e-6) < MAX_TIME_RATIO);
+}
+
+/* A million positionals: one pointer array grown by doubling */
+static char **positional_argv;
+static OptionSpec *positional_spec;
+
+static void parse_positionals(int n) {
+    ParseResult result;
+    cli_stats_reset();
+    assert(cli_parse_spec(positional_spec, n + 1, positional_argv, &result) == 0);
+    assert(result.arg_count == n);
+    CliStats stats;
+    cli_stats_get(&stats);
+    assert(stats.tokens == (unsigned long)n);
+    assert(stats.allocations <= 32);
+    assert(stats.bytes <= 4 * (unsigned long)n * sizeof(char*));
+    cli_free(&result);
+}
+
+/* Ten thousand options, every one given: one hashed lookup each */
+static Option *many_options;
+static char **option_argv;
+static int option_values[MANY_OPTIONS];
+
+static void parse_options(int n) {
+    cli_stats_reset();
+    OptionSpec *spec = cli_compile(many_options, n);
+    CliStats stats;
+    cli_stats_get(&stats);
+    assert(spec != NULL && stats.allocations == 1);
+    assert(stats.bytes <= 512 * (unsigned long)n + 4096);
+
+    ParseResult result;
+    cli_stats_reset();
+    assert(cli_parse_spec(spec, n + 1, option_argv, &result) == 0);
+    cli_stats_get(&stats);
+    assert(stats.lookups == (unsigned long)n);
+    assert(stats.probes <= 2 * (unsigned long)n);
+    assert(stats.max_probes <= 32);
+    assert(stats.allocations == (n > 512 ? 1u : 0u));   /* presence bitset past 512, freed by the parse */
+    assert(option_values[n - 1] == n - 1 && result.resources == NULL);
+    cli_free(&result);
+    cli_spec_free(spec);
+}
+
+/* One response file holding n tokens */
+static char big_token[300];
+
+static void write_response_file(int n) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/big.rsp", dir);
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    for (int i = 0; i < n; i++) {
+        fputs(i % 2 ? "x\n" : "'y z' ", f);
+    }
+    fclose(f);
+    snprintf(big_token, sizeof(big_token), "@%s", path);
+}
+
+static int response_count;
+
+static void parse_response(int n) {
+    (void)n;
+    OptionSpec *spec = cli_compile_ex(many_options, 1, CLI_RESPONSE_FILES);
+    char *argv[] = {"scale", big_token};
+    ParseResult result;
+    assert(cli_parse_spec(spec, 2, argv, &result) == 0);
+    assert(result.arg_count == response_count);
+    cli_free(&result);
+    cli_spec_free(spec);
+}
+
+/* Writing the file is not timed after the first run */
+static void parse_big_response(int n) {
+    if (response_count != n) {
+        write_response_file(n);
+        response_count = n;
+    }
+    parse_response(n);
+}
+
+static char *write_file(const char *name, const char *contents) {
+    static char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fputs(contents, f);
+    fclose(f);
+    return path;
+}
+
+static CliErrorCode parse_one(const OptionSpec *spec, char *token) {
+    char *argv[] = {"scale", token};
+    ParseContext ctx = {0};
+    cli_parse_ctx(&ctx, spec, 2, argv);
+    cli_ctx_free(&ctx);
+    return ctx.error.code;
+}
+
+int main() {
+    printf("Running SmartArgs Scalability Test...\n");
+    unsetenv("SMARTARGS_TRACE");
+    assert(mkdtemp(dir) != NULL);
+
+    // A million positionals
+    positional_argv = malloc(sizeof(char*) * (MANY_POSITIONALS + 1));
+    positional_argv[0] = "scale";
+    for (int i = 1; i <= MANY_POSITIONALS; i++) {
+        positional_argv[i] = i % 2 ? "file" : "=";
+    }
+    int verbose = 0;
+    Option flag[] = { FLAG(verbose, 'v', "verbose", "Verbose") };
+    positional_spec = cli_compile(flag, 1);
+    check_linear("positionals", parse_positionals, MANY_POSITIONALS);
+
+    // Ten thousand options
+    many_options = malloc(sizeof(Option) * MANY_OPTIONS);
+    option_argv = malloc(sizeof(char*) * (MANY_OPTIONS + 1));
+    option_argv[0] = "scale";
+    for (int i = 0; i < MANY_OPTIONS; i++) {
+        char *name = malloc(32);
+        char *token = malloc(48);
+        snprintf(name, 32, "option-%05d", i);
+        snprintf(token, 48, "--%s=%d", name, i);
+        Option opt = INT(option_values[i], 0, name, NULL);
+        many_options[i] = opt;
+        option_argv[i + 1] = token;
+    }
+    check_linear("options", parse_options, MANY_OPTIONS);
+
+    // 64KB names: found by hash, abbreviated and suggested through the trie
+    char *long_name = malloc(LONG_NAME + 1);
+    char *other_name = malloc(LONG_NAME + 1);
+    char *token = malloc(LONG_NAME + 8);
+    memset(long_name, 'n', LONG_NAME);
+    long_name[LONG_NAME] = '\0';
+    strcpy(other_name, long_name);
+    other_name[LONG_NAME - 1] = 'o';
+    int long_flag = 0, other_flag = 0;
+    Option long_options[] = {
+        FLAG(long_flag, 0, long_name, "Long"),
+        FLAG(other_flag, 0, other_name, "Other")
+    };
+    OptionSpec *exact = cli_compile(long_options, 2);
+    OptionSpec *prefix = cli_compile_ex(long_options, 2, CLI_PREFIX_MATCH);
+    snprintf(token, LONG_NAME + 8, "--%s", long_name);
+    assert(parse_one(exact, token) == CLI_OK && long_flag == 1);
+    token[LONG_NAME + 1] = 'x';
+    assert(parse_one(exact, token) == CLI_ERR_UNKNOWN_OPTION);
+    snprintf(token, LONG_NAME + 8, "--%s=1", long_name);
+    assert(parse_one(exact, token) == CLI_ERR_UNEXPECTED_VALUE);
+    token[LONG_NAME + 1] = '\0';
+    char *argv_prefix[] = {"scale", token};
+    ParseContext ctx = {0};
+    assert(cli_parse_ctx(&ctx, prefix, 2, argv_prefix) == -1);
+    assert(ctx.error.code == CLI_ERR_AMBIGUOUS_OPTION);
+    assert(ctx.error.suggestions[0] == long_options[0].long_name);
+    assert(ctx.error.suggestions[1] == long_options[1].long_name);
+    cli_ctx_free(&ctx);
+    cli_spec_free(exact);
+    cli_spec_free(prefix);
+
+    // Response files: a 16-deep chain, one level too many, and a fan-out within the depth
+    char contents[300];
+    for (int depth = 16; depth >= 0; depth--) {
+        char name[32];
+        snprintf(name, sizeof(name), "chain%02d.rsp", depth);
+        if (depth == 16) {
+            snprintf(contents, sizeof(contents), "leaf");
+        } else {
+            snprintf(contents, sizeof(contents), "level @%s/chain%02d.rsp", dir, depth + 1);
+        }
+        write_file(name, contents);
+    }
+    OptionSpec *rsp = cli_compile_ex(flag, 1, CLI_RESPONSE_FILES);
+    snprintf(contents, sizeof(contents), "@%s/chain01.rsp", dir);
+    char *argv_chain[] = {"scale", contents};
+    assert(cli_parse_ctx(&ctx, rsp, 2, argv_chain) == 0 && ctx.result.arg_count == 16);
+    cli_ctx_free(&ctx);
+    snprintf(contents, sizeof(contents), "@%s/chain00.rsp", dir);
+    assert(cli_parse_ctx(&ctx, rsp, 2, argv_chain) == -1);
+    assert(strcmp(ctx.error.message, "Response files nested too deeply") == 0);
+    cli_ctx_free(&ctx);
+
+    /* Each level names the next twice: 2^13 - 1 files within the depth limit */
+    char fan[600];
+    for (int level = 0; level <= FAN_LEVELS; level++) {
+        char name[32];
+        snprintf(name, sizeof(name), "fan%02d.rsp", level);
+        if (level == FAN_LEVELS) {
+            snprintf(fan, sizeof(fan), "x");
+        } else {
+            snprintf(fan, sizeof(fan), "@%s/fan%02d.rsp @%s/fan%02d.rsp", dir, level + 1, dir, level + 1);
+        }
+        write_file(name, fan);
+    }
+    snprintf(contents, sizeof(contents), "@%s/fan00.rsp", dir);
+    cli_stats_reset();
+    assert(cli_parse_ctx(&ctx, rsp, 2, argv_chain) == -1);
+    assert(ctx.error.code == CLI_ERR_RESPONSE_FILE);
+    assert(strcmp(ctx.error.message, "Too many response files") == 0);
+    CliStats stats;
+    cli_stats_get(&stats);
+    assert(stats.allocations <= 2 * 1024 + 32);
+    cli_ctx_free(&ctx);
+    cli_spec_free(rsp);
+
+    check_linear("response file tokens", parse_big_response, MANY_POSITIONALS);
+
+    // Malformed '=' tokens fail cleanly or are taken literally
+    int threads = 0;
+    const char *name = NULL;
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(threads, 't', "threads", "Threads"),
+        STRING(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile(options, 3);
+    assert(parse_one(spec, "=") == CLI_OK);
+    assert(parse_one(spec, "==") == CLI_OK);
+    assert(parse_one(spec, "-=") == CLI_ERR_UNKNOWN_OPTION);
+    assert(parse_one(spec, "--=") == CLI_ERR_UNKNOWN_OPTION);
+    assert(parse_one(spec, "--=verbose") == CLI_ERR_UNKNOWN_OPTION);
+    assert(parse_one(spec, "---=") == CLI_ERR_UNKNOWN_OPTION);
+    assert(parse_one(spec, "-v=") == CLI_ERR_UNKNOWN_OPTION);
+    assert(parse_one(spec, "--verbose=") == CLI_ERR_UNEXPECTED_VALUE);
+    assert(parse_one(spec, "--threads=") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one(spec, "--threads==1") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one(spec, "-t=") == CLI_ERR_INVALID_VALUE);
+    assert(parse_one(spec, "--name=") == CLI_OK && strcmp(name, "") == 0);
+    assert(parse_one(spec, "--name==") == CLI_OK && strcmp(name, "=") == 0);
+    memset(token, '=', LONG_NAME + 7);
+    token[LONG_NAME + 7] = '\0';
+    memcpy(token, "--name=", 7);
+    assert(parse_one(spec, token) == CLI_OK && strlen(name) == LONG_NAME);
+    memset(token + 2, '=', 5);
+    assert(parse_one(spec, token) == CLI_ERR_UNKNOWN_OPTION);
+    cli_spec_free(spec);
+
+    // Leave the option names and tokens to the process exit
+    free(long_name);
+    free(other_name);
+    free(token);
+    cli_spec_free(positional_spec);
+    free(positional_argv);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/big.rsp", dir);
+    unlink(path);
+    for (int depth = 0; depth <= 16; depth++) {
+        snprintf(path, sizeof(path), "%s/chain%02d.rsp", dir, depth);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/fan%02d.rsp", dir, depth);
+        unlink(path);
+    }
+    rmdir(dir);
+
+    printf("✅ All scalability tests passed!\n");
+    return 0;
+}
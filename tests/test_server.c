@@ -0,0 +1,176 @@
+/*
+ * SmartArgs Parse Server Test
+ * Sends NUL-separated requests through a pipe and a Unix socket and checks
+ * the JSON replies.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+static int verbose = 0;
+static int threads = 4;
+static const char *name = NULL;
+static double ratio = 0.5;
+static IntList ids = {NULL, 0};
+static Option options[] = {
+    FLAG(verbose, 'v', "verbose", "Verbose"),
+    INT(threads, 't', "threads", "Threads"),
+    STRING_REQUIRED(name, 'n', "name", "Name"),
+    DOUBLE(ratio, 0, "ratio", "Ratio"),
+    INT_LIST(ids, 'i', "ids", "Ids")
+};
+
+static const char requests[] =
+    "5\0job\0-vt8\0--name=a\"b\0in\0out\0"
+    "2\0job\0--bogus\0"
+    "3\0job\0--threads\0x\0"
+    "5\0job\0-n\0z\0--ratio=0.25\0-i1,-2\0";
+
+static const char replies[] =
+    "{\"status\":0,\"values\":{\"verbose\":true,\"threads\":8,\"name\":\"a\\\"b\",\"ratio\":0.5,\"ids\":[]},"
+    "\"args\":[\"in\",\"out\"]}\n"
+    "{\"status\":-1,\"error\":{\"code\":2,\"message\":\"Unknown option\",\"index\":1,\"option\":null}}\n"
+    "{\"status\":-1,\"error\":{\"code\":5,\"message\":\"Invalid integer value\",\"index\":2,"
+    "\"option\":\"threads\"}}\n"
+    "{\"status\":0,\"values\":{\"verbose\":false,\"threads\":4,\"name\":\"z\",\"ratio\":0.25,\"ids\":[1,-2]},"
+    "\"args\":[]}\n";
+
+static char socket_path[] = "/tmp/smartargs_server_XXXXXX";
+
+static void *run_server(void *arg) {
+    cli_serve_unix(arg, socket_path);
+    return NULL;
+}
+
+static size_t read_replies(int fd, char *buffer, size_t size, size_t expected) {
+    size_t len = 0;
+    while (len < expected) {
+        ssize_t n = read(fd, buffer + len, size - len - 1);
+        assert(n > 0);
+        len += (size_t)n;
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+int main() {
+    printf("Running SmartArgs Parse Server Test...\n");
+    OptionSpec *spec = cli_compile(options, 5);
+    char buffer[4096];
+
+    // Pipes: the requests arrive in one chunk and EOF ends the stream cleanly
+    int in[2], out[2];
+    assert(pipe(in) == 0 && pipe(out) == 0);
+    assert(write(in[1], requests, sizeof(requests) - 1) == (ssize_t)(sizeof(requests) - 1));
+    close(in[1]);
+    assert(cli_serve_fd(spec, in[0], out[1]) == 0);
+    close(out[1]);
+    size_t len = read_replies(out[0], buffer, sizeof(buffer), sizeof(replies) - 1);
+    assert(len == sizeof(replies) - 1 && strcmp(buffer, replies) == 0);
+    close(in[0]);
+    close(out[0]);
+
+    // The served variables are never written
+    assert(verbose == 0 && threads == 4 && name == NULL && ratio == 0.5 && ids.count == 0);
+
+    // A truncated request is an error at EOF, a bad count token at once
+    assert(pipe(in) == 0 && pipe(out) == 0);
+    assert(write(in[1], "3\0job\0-v\0", 9) == 9);
+    close(in[1]);
+    assert(cli_serve_fd(spec, in[0], out[1]) == -1);
+    close(in[0]);
+    close(out[1]);
+    close(out[0]);
+
+    assert(pipe(in) == 0 && pipe(out) == 0);
+    assert(write(in[1], "x\0job\0", 6) == 6);
+    close(in[1]);
+    assert(cli_serve_fd(spec, in[0], out[1]) == -1);
+    close(out[1]);
+    read_replies(out[0], buffer, sizeof(buffer), 1);
+    assert(strstr(buffer, "Malformed request") != NULL);
+    close(in[0]);
+    close(out[0]);
+
+    // Requests over the size limit get an error before the stream is closed
+    char big_path[] = "/tmp/smartargs_server_big_XXXXXX";
+    int big = mkstemp(big_path);
+    assert(big >= 0);
+    unlink(big_path);
+    static char filler[1 << 20];
+    memset(filler, 'x', sizeof(filler));
+    assert(write(big, "2\0job\0", 6) == 6);
+    for (int i = 0; i < 17; i++) {
+        assert(write(big, filler, sizeof(filler)) == (ssize_t)sizeof(filler));
+    }
+    assert(lseek(big, 0, SEEK_SET) == 0);
+    assert(pipe(out) == 0);
+    assert(cli_serve_fd(spec, big, out[1]) == -1);
+    close(out[1]);
+    read_replies(out[0], buffer, sizeof(buffer), 1);
+    assert(strstr(buffer, "Request too large") != NULL);
+    close(big);
+    close(out[0]);
+
+    // Replies never depend on the server's own environment
+    int level = 1;
+    Option env_options[] = {
+        OPTION_ENV(OPT_INT, level, 'l', "level", "Level", "SMARTARGS_SERVER_LEVEL")
+    };
+    OptionSpec *env_spec = cli_compile(env_options, 1);
+    setenv("SMARTARGS_SERVER_LEVEL", "9", 1);
+    assert(pipe(in) == 0 && pipe(out) == 0);
+    assert(write(in[1], "1\0job\0", 6) == 6);
+    close(in[1]);
+    assert(cli_serve_fd(env_spec, in[0], out[1]) == 0);
+    close(out[1]);
+    const char env_reply[] = "{\"status\":0,\"values\":{\"level\":1},\"args\":[]}\n";
+    read_replies(out[0], buffer, sizeof(buffer), sizeof(env_reply) - 1);
+    assert(strcmp(buffer, env_reply) == 0);
+    close(in[0]);
+    close(out[0]);
+    unsetenv("SMARTARGS_SERVER_LEVEL");
+    cli_spec_free(env_spec);
+
+    // Unix socket: requests split across writes are reassembled
+    int tmp = mkstemp(socket_path);
+    assert(tmp >= 0);
+    close(tmp);
+    unlink(socket_path);
+    pthread_t server;
+    assert(pthread_create(&server, NULL, run_server, spec) == 0);
+    pthread_detach(server);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    int fd = -1;
+    for (int attempt = 0; attempt < 500 && fd < 0; attempt++) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+            usleep(2000);
+        }
+    }
+    assert(fd >= 0);
+    assert(write(fd, requests, 10) == 10);
+    usleep(1000);
+    assert(write(fd, requests + 10, sizeof(requests) - 11) == (ssize_t)(sizeof(requests) - 11));
+    len = read_replies(fd, buffer, sizeof(buffer), sizeof(replies) - 1);
+    assert(len == sizeof(replies) - 1 && strcmp(buffer, replies) == 0);
+    close(fd);
+    unlink(socket_path);
+
+    printf("✅ All parse server tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * SmartArgs Snapshot Test
+ * Parses through cli_parse_cached(): the first run writes the snapshot and
+ * the next identical one loads it instead of parsing. Changed argv, config
+ * files and defaults, damaged snapshots and forged keys fall back to a
+ * real parse.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+enum { VERBOSE, LEVEL, THREADS, OFFSET, SEED, LIMIT, TIMEOUT, RATIO, NAME, LABEL, IDS, WEIGHTS, TAGS,
+       OPTION_COUNT };
+
+static int verbose, level, threads;
+static int64_t offset, timeout;
+static uint64_t seed;
+static size_t limit;
+static double ratio;
+static const char *name;
+static StringView label;
+static IntList ids;
+static DoubleList weights;
+static StringList tags;
+
+static void reset(void) {
+    verbose = level = threads = 0;
+    offset = timeout = 0;
+    seed = 0;
+    limit = 0;
+    ratio = 0;
+    name = NULL;
+    memset(&label, 0, sizeof(label));
+    memset(&ids, 0, sizeof(ids));
+    memset(&weights, 0, sizeof(weights));
+    memset(&tags, 0, sizeof(tags));
+}
+
+/* A value straight from argv means the tokens were parsed, not loaded */
+static int from_argv(const char *p, int argc, char **argv) {
+    for (int i = 0; i < argc; i++) {
+        if (p >= argv[i] && p <= argv[i] + strlen(argv[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void check_values(const ParseContext *ctx, char **argv) {
+    assert(verbose == 1 && level == 3 && threads == 8 && offset == -5 && seed == 42);
+    assert(limit == 4096 && timeout == 1500000000LL && ratio == 0.25);
+    assert(strcmp(name, "job") == 0 && label.length == 4 && memcmp(label.data, "east", 4) == 0);
+    assert(ids.count == 3 && ids.items[0] == 1 && ids.items[2] == 3);
+    assert(weights.count == 2 && weights.items[1] == 2.5);
+    assert(tags.count == 1 && strcmp(tags.items[0], "a,b") == 0);
+    assert(ctx->result.arg_count == 2);
+    assert(ctx->result.args[0] == argv[3] && ctx->result.args[1] == argv[17]);   /* argv itself */
+}
+
+int main() {
+    printf("Running SmartArgs Snapshot Test...\n");
+    char dir[] = "/tmp/smartargs_snapshot_XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+    char cache[256], config[256];
+    snprintf(cache, sizeof(cache), "%s/app.snap", dir);
+    snprintf(config, sizeof(config), "%s/app.ini", dir);
+    FILE *f = fopen(config, "w");
+    assert(f != NULL);
+    fputs("seed = 42\ntag = a,b\n", f);
+    fclose(f);
+
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        COUNT(level, 'L', "level", "Level"),
+        INT(threads, 't', "threads", "Threads"),
+        INT64(offset, 'o', "offset", "Offset"),
+        UINT64(seed, 0, "seed", "Seed"),
+        SIZE(limit, 'l', "limit", "Limit"),
+        DURATION(timeout, 0, "timeout", "Timeout"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio"),
+        STRING_REQUIRED(name, 'n', "name", "Name"),
+        STRING_VIEW(label, 0, "label", "Label"),
+        INT_LIST(ids, 'i', "ids", "Ids"),
+        DOUBLE_LIST(weights, 'w', "weights", "Weights"),
+        STRING_LIST(tags, 0, "tag", "Tags")
+    };
+    OptionSpec *spec = cli_compile(options, OPTION_COUNT);
+    char *argv[] = {"app", "-vLLL", "-t8", "in", "-o", "-5", "--limit=4k", "--timeout=1.5s", "-r", "0.25",
+                    "--name=job", "--label", "east", "-i1,2", "--ids=3", "-w", "1,2.5", "out"};
+    int argc = 18;
+    unsigned counts[OPTION_COUNT];
+    ParseContext ctx = {0};
+    ctx.counts = counts;
+    ctx.config_path = config;
+
+    // The first run parses and writes the snapshot, the second loads it
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    check_values(&ctx, argv);
+    assert(from_argv(name, argc, argv) && access(cache, R_OK) == 0);
+    cli_ctx_free(&ctx);
+
+    reset();
+    memset(counts, 0xff, sizeof(counts));
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    check_values(&ctx, argv);
+    assert(!from_argv(name, argc, argv) && !from_argv(label.data, argc, argv));
+    assert(counts[LEVEL] == 3 && counts[IDS] == 2 && counts[SEED] == 1 && counts[VERBOSE] == 1);
+    assert(counts[TAGS] == 1 && counts[NAME] == 1);
+    cli_ctx_free(&ctx);
+
+    // Values go where the parse would put them
+    OptionValue values[OPTION_COUNT];
+    memset(values, 0, sizeof(values));
+    ctx.values = values;
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(values[THREADS].i == 8 && threads == 0 && strcmp(values[NAME].s, "job") == 0);
+    assert(values[WEIGHTS].doubles.count == 2 && !from_argv(values[NAME].s, argc, argv));
+    ctx.values = NULL;
+    cli_ctx_free(&ctx);
+
+    // A different argv is parsed, and replaces the snapshot
+    argv[2] = "-t9";
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(threads == 9 && from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(threads == 9 && !from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+    argv[2] = "-t8";
+
+    // So is a different starting count, or a changed config file
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    cli_ctx_free(&ctx);
+    reset();
+    level = 10;
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(level == 13 && from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+    f = fopen(config, "w");
+    assert(f != NULL);
+    fputs("seed = 1043\ntag = a,b\n", f);   /* a new size, whatever the mtime resolution */
+    fclose(f);
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(seed == 1043 && from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+
+    // A matching key is not enough: the snapshot of -t9 given the key of -t8 is parsed over
+    uint64_t key_t8, key_t9;
+    f = fopen(cache, "rb");
+    assert(f != NULL && fseek(f, 8, SEEK_SET) == 0 && fread(&key_t8, sizeof(key_t8), 1, f) == 1);
+    fclose(f);
+    argv[2] = "-t9";
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0 && threads == 9);
+    cli_ctx_free(&ctx);
+    argv[2] = "-t8";
+    f = fopen(cache, "r+b");
+    assert(f != NULL && fseek(f, 8, SEEK_SET) == 0 && fread(&key_t9, sizeof(key_t9), 1, f) == 1);
+    assert(key_t9 != key_t8 && fseek(f, 8, SEEK_SET) == 0 && fwrite(&key_t8, sizeof(key_t8), 1, f) == 1);
+    fclose(f);
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(threads == 8 && from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+
+    // A damaged snapshot is parsed over
+    f = fopen(cache, "r+");
+    assert(f != NULL);
+    fseek(f, 64, SEEK_SET);
+    fputs("garbage garbage garbage garbage", f);
+    fclose(f);
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0);
+    assert(seed == 1043 && threads == 8 && tags.count == 1);
+    cli_ctx_free(&ctx);
+    assert(truncate(cache, 30) == 0);
+    reset();
+    assert(cli_parse_cached(&ctx, spec, argc, argv, cache) == 0 && from_argv(name, argc, argv));
+    cli_ctx_free(&ctx);
+
+    // Failed parses are not cached
+    unlink(cache);
+    assert(cli_parse_cached(&ctx, spec, 3, argv, cache) == -1);
+    assert(ctx.error.code == CLI_ERR_REQUIRED_MISSING && access(cache, F_OK) != 0);
+    cli_ctx_free(&ctx);
+
+    cli_spec_free(spec);
+    unlink(config);
+    rmdir(dir);
+    printf("✅ All snapshot tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * SmartArgs Compiled Spec Test
+ * Compiles a large option table once and reuses it for several parses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define OPTION_COUNT 300
+
+int main() {
+    printf("Running SmartArgs Compiled Spec Test...\n");
+
+    static char names[OPTION_COUNT][16];
+    static int values[OPTION_COUNT];
+    Option options[OPTION_COUNT + 1];
+    int help = 0;
+
+    for (int i = 0; i < OPTION_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "opt-%d", i);
+        Option opt = INT(values[i], 0, names[i], "Generated option");
+        options[i] = opt;
+    }
+    Option help_opt = FLAG(help, 'h', "help", "Help");
+    options[OPTION_COUNT] = help_opt;
+
+    OptionSpec *spec = cli_compile(options, OPTION_COUNT + 1);
+    assert(spec != NULL);
+
+    // Every declared name must resolve to its own option
+    for (int i = 0; i < OPTION_COUNT; i++) {
+        char flag[24];
+        char value[16];
+        snprintf(flag, sizeof(flag), "--opt-%d", i);
+        snprintf(value, sizeof(value), "%d", i * 7);
+        char *argv[] = {"test", flag, value};
+
+        ParseResult result;
+        assert(cli_parse_spec(spec, 3, argv, &result) == 0);
+        assert(values[i] == i * 7);
+        cli_free(&result);
+    }
+
+    // Prefixes and near misses of declared names are not matches
+    char *bad_argv[] = {"test", "--opt-", "1"};
+    ParseResult result;
+    assert(cli_parse_spec(spec, 3, bad_argv, &result) != 0);
+    assert(strcmp(result.error, "Unknown option") == 0);
+    cli_free(&result);
+
+    // The help flag is resolved at compile time and suppresses required checks
+    char *help_argv[] = {"test", "--help", "file"};
+    assert(cli_parse_spec(spec, 3, help_argv, &result) == 0);
+    assert(help == 1);
+    assert(result.arg_count == 1);
+    cli_free(&result);
+
+    cli_spec_free(spec);
+
+    // Short options: bundled flags and attached values in one token
+    int verbose = 0, keep = 0, threads = 0;
+    const char *output = NULL;
+    Option short_options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        FLAG(keep, 'k', "keep", "Keep"),
+        INT(threads, 't', "threads", "Threads"),
+        STRING(output, 'o', "output", "Output")
+    };
+    char *short_argv[] = {"test", "-vvk", "-t8", "-ofile.txt", "-vt", "16", "rest"};
+    assert(cli_parse(7, short_argv, short_options, 4, &result) == 0);
+    assert(verbose == 1 && keep == 1);
+    assert(threads == 16);
+    assert(strcmp(output, "file.txt") == 0);
+    assert(result.arg_count == 1 && strcmp(result.args[0], "rest") == 0);
+    cli_free(&result);
+
+    char *missing_argv[] = {"test", "-vt"};
+    assert(cli_parse(2, missing_argv, short_options, 4, &result) != 0);
+    assert(strcmp(result.error, "Option requires a value") == 0);
+    cli_free(&result);
+
+    char *unknown_argv[] = {"test", "-vx"};
+    assert(cli_parse(2, unknown_argv, short_options, 4, &result) != 0);
+    cli_free(&result);
+
+    // CLI_PERMUTE: positionals end up contiguous at the tail of argv
+    OptionSpec *permute_spec = cli_compile_ex(short_options, 4, CLI_PERMUTE);
+    assert(permute_spec != NULL);
+    threads = 0;
+    output = NULL;
+    char *permute_argv[] = {"test", "a", "--threads", "4", "b", "-v", "c", "-o", "out", "--", "-d"};
+    assert(cli_parse_spec(permute_spec, 11, permute_argv, &result) == 0);
+    assert(result.args_borrowed);
+    assert(result.args == permute_argv + 7);
+    assert(result.arg_count == 4);
+    assert(strcmp(result.args[0], "a") == 0);
+    assert(strcmp(result.args[1], "b") == 0);
+    assert(strcmp(result.args[2], "c") == 0);
+    assert(strcmp(result.args[3], "-d") == 0);
+    assert(strcmp(permute_argv[1], "--threads") == 0 && strcmp(permute_argv[2], "4") == 0);
+    assert(strcmp(permute_argv[6], "--") == 0);
+    assert(threads == 4 && strcmp(output, "out") == 0);
+    cli_free(&result);
+    cli_spec_free(permute_spec);
+
+    printf("✅ All compiled spec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * SmartArgs Instrumentation Test
+ * Built with its own copy of the library compiled with SMARTARGS_STATS;
+ * checks the counters and the hidden --smartargs-trace flag.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+int main() {
+    printf("Running SmartArgs Instrumentation Test...\n");
+    unsetenv("SMARTARGS_TRACE");
+
+    int verbose = 0, threads = 0;
+    double ratio = 0;
+    const char *name = NULL;
+    Option options[] = {
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        INT(threads, 't', "threads", "Threads"),
+        DOUBLE(ratio, 'r', "ratio", "Ratio"),
+        STRING_REQUIRED(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile(options, 4);
+
+    // 6 tokens, 3 of them long options looked up in the hash table
+    char *argv[] = {"app", "--threads", "8", "--ratio=0.5", "-v", "--name", "x"};
+    ParseResult result;
+    cli_stats_reset();
+    assert(cli_parse_spec(spec, 7, argv, &result) == 0);
+    CliStats stats;
+    cli_stats_get(&stats);
+    assert(stats.tokens == 6);
+    assert(stats.lookups == 3);
+    assert(stats.probes >= 3 && stats.max_probes >= 1);
+    assert(stats.allocations == 0);  /* no positionals, spec compiled before */
+    cli_free(&result);
+
+    // Positionals allocate; the counters accumulate until reset
+    char *positional_argv[] = {"app", "-n", "x", "a", "b"};
+    assert(cli_parse_spec(spec, 5, positional_argv, &result) == 0);
+    cli_stats_get(&stats);
+    assert(stats.tokens == 10);
+    assert(stats.allocations == 1 && stats.bytes == 4 * sizeof(char*));
+    cli_free(&result);
+
+    // Failing parses are timed too: a bad token ends the scan, a missing option the check
+    char *unknown_argv[] = {"app", "-n", "x", "--bogus"};
+    cli_stats_reset();
+    assert(cli_parse_spec(spec, 4, unknown_argv, &result) == -1);
+    cli_stats_get(&stats);
+    assert(stats.scan_ns > 0 && stats.required_ns == 0);
+    cli_free(&result);
+    char *missing_argv[] = {"app", "-v"};
+    cli_stats_reset();
+    assert(cli_parse_spec(spec, 2, missing_argv, &result) == -1);
+    cli_stats_get(&stats);
+    assert(stats.scan_ns > 0 && stats.required_ns > 0);
+    cli_free(&result);
+
+    // The trace flag is consumed and dumps JSON to stderr
+    char path[] = "/tmp/smartargs_stats_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    fflush(stderr);
+    int saved = dup(2);
+    dup2(fd, 2);
+    char *trace_argv[] = {"app", "--smartargs-trace", "-n", "x", "file"};
+    assert(cli_parse_spec(spec, 5, trace_argv, &result) == 0);
+    assert(result.arg_count == 1 && strcmp(result.args[0], "file") == 0);
+    cli_free(&result);
+    fflush(stderr);
+    dup2(saved, 2);
+    close(saved);
+
+    char buffer[512] = {0};
+    assert(pread(fd, buffer, sizeof(buffer) - 1, 0) > 0);
+    assert(strncmp(buffer, "{\"smartargs\":{\"tokens\":", 23) == 0);
+    assert(strstr(buffer, "\"scan_ns\":") != NULL);
+    close(fd);
+    unlink(path);
+
+    cli_spec_free(spec);
+    printf("✅ All instrumentation tests passed!\n");
+    return 0;
+}
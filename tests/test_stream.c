@@ -0,0 +1,211 @@
+/*
+ * SmartArgs Stream Test
+ * Parses NUL-separated tokens from files and pipes with cli_parse_fd():
+ * cmdline format, tokens across chunk boundaries, errors, and long
+ * streams of positionals and repeated options parsed in bounded memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+#define STREAM_TOKENS 200000
+#define BIG_TOKEN (200 * 1024)
+
+static int fd_with(const char *data, size_t len) {
+    char path[] = "/tmp/smartargs_stream_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    assert(write(fd, data, len) == (ssize_t)len);
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
+/* Counts live bytes through a size header to find the peak */
+typedef struct {
+    size_t live;
+    size_t peak;
+} Usage;
+
+static void *usage_alloc(void *userdata, size_t size) {
+    Usage *u = userdata;
+    size_t *block = malloc(sizeof(size_t) * 2 + size);
+    if (!block) {
+        return NULL;
+    }
+    block[0] = size;
+    u->live += size;
+    u->peak = u->live > u->peak ? u->live : u->peak;
+    return block + 2;
+}
+
+static void usage_free(void *userdata, void *ptr) {
+    Usage *u = userdata;
+    size_t *block = (size_t*)ptr - 2;
+    u->live -= block[0];
+    free(block);
+}
+
+static void *usage_realloc(void *userdata, void *ptr, size_t size) {
+    void *grown = usage_alloc(userdata, size);
+    if (grown && ptr) {
+        size_t old = ((size_t*)ptr)[-2];
+        memcpy(grown, ptr, old < size ? old : size);
+        usage_free(userdata, ptr);
+    }
+    return grown;
+}
+
+typedef struct {
+    long count;
+    long bytes;
+    int stop_at;
+} Seen;
+
+static int on_path(StringView arg, void *userdata) {
+    Seen *seen = userdata;
+    assert(arg.length > 0 && arg.data[arg.length] == '\0');
+    seen->count++;
+    seen->bytes += (long)arg.length;
+    return seen->stop_at && seen->count == seen->stop_at;
+}
+
+int main() {
+    printf("Running SmartArgs Stream Test...\n");
+
+    int threads = 0, verbose = 0;
+    const char *name = NULL;
+    Option options[] = {
+        INT(threads, 't', "threads", "Threads"),
+        FLAG(verbose, 'v', "verbose", "Verbose"),
+        STRING(name, 'n', "name", "Name")
+    };
+    OptionSpec *spec = cli_compile(options, 3);
+    ParseContext ctx = {0};
+
+    // cmdline format: argv[0] first, every token terminated
+    const char cmdline[] = "prog\0-t\0" "8\0--name=job\0a\0b\0";
+    int fd = fd_with(cmdline, sizeof(cmdline) - 1);
+    assert(cli_parse_fd(&ctx, spec, fd, NULL) == 0);
+    close(fd);
+    assert(threads == 8 && strcmp(name, "job") == 0);
+    assert(ctx.result.arg_count == 2 && strcmp(ctx.result.args[0], "a") == 0 && strcmp(ctx.result.args[1], "b") == 0);
+    cli_ctx_free(&ctx);
+
+    // Arguments only, the last one unterminated; -- still ends the options
+    const char args[] = "-v\0-n\0x\0--\0-t\0last";
+    fd = fd_with(args, sizeof(args) - 1);
+    verbose = 0;
+    assert(cli_parse_fd(&ctx, spec, fd, "tool") == 0);
+    close(fd);
+    assert(verbose && strcmp(name, "x") == 0 && ctx.result.arg_count == 2);
+    assert(strcmp(ctx.result.args[0], "-t") == 0 && strcmp(ctx.result.args[1], "last") == 0);
+    cli_ctx_free(&ctx);
+
+    // Tokens longer than a chunk, and values across chunk boundaries
+    char *big = malloc(BIG_TOKEN + 16);
+    assert(big != NULL);
+    memset(big, 'x', BIG_TOKEN);
+    memcpy(big + BIG_TOKEN, "\0-n\0big\0", 8);
+    fd = fd_with(big, BIG_TOKEN + 8);
+    assert(cli_parse_fd(&ctx, spec, fd, "tool") == 0);
+    close(fd);
+    assert(ctx.result.arg_count == 1 && strlen(ctx.result.args[0]) == BIG_TOKEN && strcmp(name, "big") == 0);
+    cli_ctx_free(&ctx);
+    free(big);
+
+    // Errors carry the token index, counted from argv[0]
+    const char missing[] = "prog\0a\0-t";
+    fd = fd_with(missing, sizeof(missing) - 1);
+    assert(cli_parse_fd(&ctx, spec, fd, NULL) == -1);
+    close(fd);
+    assert(ctx.error.code == CLI_ERR_MISSING_VALUE && ctx.error.index == 2);
+    cli_ctx_free(&ctx);
+    assert(cli_parse_fd(&ctx, spec, -1, "tool") == -1);
+    assert(ctx.error.code == CLI_ERR_INVALID_ARGUMENTS && strcmp(ctx.error.message, "Cannot read argument stream") == 0);
+    cli_ctx_free(&ctx);
+
+    // A long pipe of streamed positionals with options among them, in bounded memory
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        close(pipefd[0]);
+        FILE *out = fdopen(pipefd[1], "w");
+        for (int i = 0; i < STREAM_TOKENS; i++) {
+            if (i == STREAM_TOKENS / 2) {
+                fputs("-t", out);
+                fputc('\0', out);
+                fputs("16", out);
+                fputc('\0', out);
+                fputs("--name=middle", out);
+                fputc('\0', out);
+            }
+            fprintf(out, "/data/dir%03d/file%06d.txt", i % 1000, i);
+            fputc('\0', out);
+        }
+        fclose(out);
+        _exit(0);
+    }
+    close(pipefd[1]);
+    Usage usage = {0, 0};
+    CliAllocator allocator = {usage_alloc, usage_realloc, usage_free, &usage};
+    Seen seen = {0, 0, 0};
+    ctx.allocator = &allocator;
+    ctx.on_positional = on_path;
+    ctx.userdata = &seen;
+    assert(cli_parse_fd(&ctx, spec, pipefd[0], "tool") == 0);
+    close(pipefd[0]);
+    waitpid(child, NULL, 0);
+    assert(seen.count == STREAM_TOKENS && seen.bytes > 4 * 1024 * 1024);
+    assert(threads == 16 && strcmp(name, "middle") == 0);
+    assert(usage.peak < 256 * 1024);   /* one chunk and the option tokens */
+    cli_ctx_free(&ctx);
+    assert(usage.live == 0);
+
+    // Options repeated on every token reuse their copies instead of piling up
+    assert(pipe(pipefd) == 0);
+    child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        close(pipefd[0]);
+        FILE *out = fdopen(pipefd[1], "w");
+        for (int i = 0; i < STREAM_TOKENS; i++) {
+            fprintf(out, "-v%c-t%c%d%c--name=job%06d%cfile%c", 0, 0, i % 100, 0, i, 0, 0);
+        }
+        fclose(out);
+        _exit(0);
+    }
+    close(pipefd[1]);
+    usage.peak = 0;
+    seen.count = 0;
+    seen.bytes = 0;
+    assert(cli_parse_fd(&ctx, spec, pipefd[0], "tool") == 0);
+    close(pipefd[0]);
+    waitpid(child, NULL, 0);
+    assert(seen.count == STREAM_TOKENS && verbose);
+    assert(threads == (STREAM_TOKENS - 1) % 100 && strcmp(name, "job199999") == 0);
+    assert(usage.peak < 256 * 1024);
+    cli_ctx_free(&ctx);
+    assert(usage.live == 0);
+
+    // The callback can stop the stream
+    const char paths[] = "prog\0a\0b\0c\0d\0";
+    fd = fd_with(paths, sizeof(paths) - 1);
+    Seen stop = {0, 0, 2};
+    ctx.userdata = &stop;
+    assert(cli_parse_fd(&ctx, spec, fd, NULL) == 1 && stop.count == 2 && ctx.result.arg_count == 0);
+    close(fd);
+    cli_ctx_free(&ctx);
+
+    cli_spec_free(spec);
+    printf("✅ All stream tests passed!\n");
+    return 0;
+}
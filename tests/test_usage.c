@@ -0,0 +1,149 @@
+/*
+ * SmartArgs Usage Text Test
+ * Captures the rendered usage and error hint and checks the alignment,
+ * wrapping and reuse of the cached text, and what CONFIGURE and
+ * CONFIGURE_HINT print on an error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#undef NDEBUG  /* keep assertions active in Release builds */
+#include <assert.h>
+#include "smartargs.h"
+
+static char dir[] = "/tmp/smartargs_usage_XXXXXX";
+
+/* Run print with fd redirected to a file and return what it wrote */
+static char *capture(int fd, void (*print)(const OptionSpec*), const OptionSpec *spec) {
+    static char text[4096];
+    char path[256];
+    snprintf(path, sizeof(path), "%s/out.txt", dir);
+    FILE *f = fopen(path, "w+");
+    assert(f != NULL);
+    fflush(NULL);
+    int saved = dup(fd);
+    dup2(fileno(f), fd);
+    print(spec);
+    dup2(saved, fd);
+    close(saved);
+    rewind(f);
+    size_t len = fread(text, 1, sizeof(text) - 1, f);
+    text[len] = '\0';
+    fclose(f);
+    unlink(path);
+    return text;
+}
+
+static void print_usage(const OptionSpec *spec) {
+    cli_spec_usage(spec, "tool", "Does things.");
+}
+
+static void print_hint(const OptionSpec *spec) {
+    cli_usage_hint(spec, "tool", "Unknown option");
+}
+
+static void print_plain(const OptionSpec *spec) {
+    int count;
+    Option *options = (Option*)cli_spec_options(spec, &count);
+    cli_usage("tool", options, count, NULL);
+}
+
+/* Output of a child exiting through CONFIGURE or CONFIGURE_HINT on a bad option */
+static char *configure_error(int hint) {
+    static char text[4096];
+    char path[256];
+    snprintf(path, sizeof(path), "%s/err.txt", dir);
+    fflush(NULL);
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        assert(freopen(path, "w", stderr) != NULL);
+        dup2(fileno(stderr), STDOUT_FILENO);   /* the usage goes to stdout */
+        int help = 0, threads = 1;
+        char *argv[] = {"tool", "--bogus"};
+        if (hint) {
+            CONFIGURE_HINT(2, argv, "Does things.", help, INT(threads, 't', "threads", "Threads"));
+        } else {
+            CONFIGURE(2, argv, "Does things.", help, INT(threads, 't', "threads", "Threads"));
+        }
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 1);
+    FILE *f = fopen(path, "r");
+    assert(f != NULL);
+    size_t len = fread(text, 1, sizeof(text) - 1, f);
+    text[len] = '\0';
+    fclose(f);
+    unlink(path);
+    return text;
+}
+
+int main() {
+    printf("Running SmartArgs Usage Text Test...\n");
+    assert(mkdtemp(dir) != NULL);
+    setenv("COLUMNS", "50", 1);
+
+    int help = 0, verbose = 0, threads = 1;
+    const char *name = NULL;
+    IntList ids = {NULL, 0};
+    Option options[] = {
+        HELP(help),
+        FLAG(verbose, 'v', "verbose", "Print every step, including the ones nobody wants to see"),
+        INT(threads, 't', "threads", "Threads"),
+        STRING_REQUIRED(name, 0, "name", "Job name"),
+        INT_LIST(ids, 0, "an-unreasonably-long-option", "Ids")
+    };
+    OptionSpec *spec = cli_compile(options, 5);
+
+    const char *expected =
+        "Usage: tool [options] [arguments]\n"
+        "\n"
+        "Does things.\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help           Show this help message\n"
+        "  -v, --verbose        Print every step, including\n"
+        "                       the ones nobody wants to\n"
+        "                       see\n"
+        "  -t, --threads <num>  Threads\n"
+        "      --name <string>  Job name (required)\n"
+        "      --an-unreasonably-long-option <num,...>\n"
+        "                       Ids\n";
+    assert(strcmp(capture(STDOUT_FILENO, print_usage, spec), expected) == 0);
+    // The second call prints the cached text
+    assert(strcmp(capture(STDOUT_FILENO, print_usage, spec), expected) == 0);
+
+    // A wider terminal renders again
+    setenv("COLUMNS", "200", 1);
+    char *wide = strdup(capture(STDOUT_FILENO, print_usage, spec));
+    assert(strstr(wide, "  -v, --verbose        Print every step, including the ones nobody wants to see\n") != NULL);
+
+    // cli_usage renders the same text without a spec cache
+    char *plain = capture(STDOUT_FILENO, print_plain, spec);
+    assert(strncmp(plain, "Usage: tool [options] [arguments]\n\nOptions:\n", 44) == 0);
+    assert(strcmp(plain + 34, wide + 48) == 0);
+    free(wide);
+
+    // The hint points at the help flag, or shows the usage line without one
+    assert(strcmp(capture(STDERR_FILENO, print_hint, spec),
+                  "Error: Unknown option\nTry 'tool --help' for more information.\n") == 0);
+    OptionSpec *bare = cli_compile(options + 1, 2);
+    assert(strcmp(capture(STDERR_FILENO, print_hint, bare),
+                  "Error: Unknown option\nUsage: tool [options] [arguments]\n") == 0);
+    cli_spec_free(bare);
+
+    // CONFIGURE shows the whole usage after an error, CONFIGURE_HINT one line
+    char *full = configure_error(0);
+    assert(strstr(full, "Error: Unknown option\n") != NULL && strstr(full, "  -t, --threads <num>") != NULL);
+    assert(strcmp(configure_error(1), "Error: Unknown option\nTry 'tool --help' for more information.\n") == 0);
+
+    cli_spec_free(spec);
+    rmdir(dir);
+
+    printf("✅ All usage text tests passed!\n");
+    return 0;
+}